@@ -0,0 +1,304 @@
+#include "GUI/MiniGUI.h"
+#include "GUI/Timer.h"
+#include "DisasterParser.h"
+#include "DisasterOptimizer.h"
+#include "DisasterStats.h"
+#include "filelib.h"
+#include "strlib.h"
+#include "simpio.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#if defined(_WIN32)
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+namespace {
+    /* File constants. */
+    const string kProblemSuffix = ".dst";
+    const string kBasePath      = "res/disaster-planning/";
+    const string kCSVFile       = "disaster-benchmark.csv";
+    const string kJSONFile      = "disaster-benchmark.json";
+
+    /* Maps whose names start with these are too slow to include by default. */
+    const vector<string> kSlowPrefixes = { "VeryHard", "VirtuallyImpossible" };
+
+    /* Whether the solver fills in node counts in this build. */
+#ifdef DISASTER_ENABLE_STATS
+    const bool kStatsEnabled = true;
+#else
+    const bool kStatsEnabled = false;
+#endif
+
+    /* Summary of repeated measurements of one quantity. */
+    struct Summary {
+        double median;
+        double p95;
+    };
+
+    /* Everything measured about one map. */
+    struct Measurement {
+        string file;
+        int    numCities;
+        int    numRoads;
+        int    optimal;      // Minimum number of depots found
+        Summary seconds;     // Wall time per solve
+        long long nodes;     // Search nodes per solve, or -1 if not counted
+        long long peakBytes; // Peak resident memory, or -1 if unavailable
+    };
+
+    /* Returns the given percentile of a list of samples, using the nearest-rank
+     * method: the smallest sample that's at least as large as p percent of the
+     * samples.
+     */
+    double percentile(vector<double> samples, double p) {
+        if (samples.empty()) error("Can't take a percentile of no samples.");
+
+        sort(samples.begin(), samples.end());
+        int rank = int(ceil(p / 100.0 * samples.size()));
+        return samples[max(rank, 1) - 1];
+    }
+
+    Summary summarize(const vector<double>& samples) {
+        return { percentile(samples, 50), percentile(samples, 95) };
+    }
+
+    /* On Linux, resets the process's peak memory high-water mark so that the next
+     * reading reflects only what happens after this call. Other platforms don't
+     * offer a way to do this, so there the reading is the peak for the whole run.
+     */
+    void resetPeakMemory() {
+#if defined(__linux__)
+        ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5" << flush;
+#endif
+    }
+
+    /* Returns the peak resident memory of this process in bytes, or -1 if that
+     * can't be determined.
+     */
+    long long peakMemory() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+        return counters.PeakWorkingSetSize;
+#elif defined(__linux__)
+        /* VmHWM respects resets through clear_refs, unlike getrusage. */
+        ifstream status("/proc/self/status");
+        for (string line; getline(status, line); ) {
+            if (startsWith(line, "VmHWM:")) {
+                long long kilobytes;
+                istringstream fields(line.substr(string("VmHWM:").size()));
+                return (fields >> kilobytes)? kilobytes * 1024 : -1;
+            }
+        }
+        return -1;
+#else
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+#if defined(__APPLE__)
+        return usage.ru_maxrss; // Bytes on macOS...
+#else
+        return usage.ru_maxrss * 1024LL; // ... and kilobytes everywhere else
+#endif
+#endif
+    }
+
+    int numRoadsIn(const DisasterTest& test) {
+        int result = 0;
+        for (const string& city: test.network) {
+            result += test.network[city].size();
+        }
+        return result / 2;
+    }
+
+    bool isSlow(const string& file) {
+        for (const string& prefix: kSlowPrefixes) {
+            if (startsWith(file, prefix)) return true;
+        }
+        return false;
+    }
+
+    /* Lists the maps to benchmark, in alphabetical order. */
+    vector<string> benchmarkFiles(bool includeSlow) {
+        vector<string> result;
+        for (const string& file: listDirectory(kBasePath)) {
+            if (endsWith(file, kProblemSuffix) && (includeSlow || !isSlow(file))) {
+                result.push_back(file);
+            }
+        }
+        sort(result.begin(), result.end());
+        return result;
+    }
+
+    /* Solves the given map the given number of times, timing each run. One thread
+     * means the sequential solveOptimally; anything more means the parallel version.
+     */
+    Measurement measure(const string& file, int repetitions, int numThreads) {
+        DisasterTest test = loadDisasterFile(kBasePath + file);
+
+        Measurement result;
+        result.file      = file;
+        result.numCities = test.network.size();
+        result.numRoads  = numRoadsIn(test);
+
+        resetPeakMemory();
+
+        vector<double> seconds;
+        SearchStats stats;
+        for (int i = 0; i < repetitions; i++) {
+            /* Every run explores the same nodes, so only count the first. */
+            Set<string> solution;
+            Timing::Timer timer;
+            timer.start();
+            if (numThreads == 1) {
+                solveOptimally(test, solution, i == 0? &stats : nullptr);
+            } else {
+                solveOptimallyInParallel(test, solution, numThreads);
+            }
+            timer.stop();
+
+            seconds.push_back(timer.elapsed());
+            result.optimal = solution.size();
+        }
+
+        result.seconds   = summarize(seconds);
+        result.nodes     = kStatsEnabled && numThreads == 1? stats.nodesVisited : -1;
+        result.peakBytes = peakMemory();
+        return result;
+    }
+
+    /* Quotes a string for use as a CSV field, doubling any quotes inside it, so commas
+     * and line breaks in it don't split the field.
+     */
+    string csvField(const string& text) {
+        string result = "\"";
+        for (char ch: text) {
+            if (ch == '"') result += '"';
+            result += ch;
+        }
+        return result + "\"";
+    }
+
+    void writeCSV(ostream& out, const string& label, int repetitions, int numThreads,
+                  const vector<Measurement>& results) {
+        out << "label,file,cities,roads,optimal,repetitions,threads,median_seconds,p95_seconds,nodes,peak_bytes" << endl;
+        for (const auto& entry: results) {
+            out << csvField(label)      << ","
+                << csvField(entry.file) << ","
+                << entry.numCities      << ","
+                << entry.numRoads       << ","
+                << entry.optimal        << ","
+                << repetitions          << ","
+                << numThreads           << ","
+                << entry.seconds.median << ","
+                << entry.seconds.p95    << ","
+                << entry.nodes          << ","
+                << entry.peakBytes      << endl;
+        }
+    }
+
+    /* Escapes a string for use inside a JSON string literal. */
+    string jsonString(const string& text) {
+        string result = "\"";
+        for (char ch: text) {
+            if (ch == '"' || ch == '\\') result += '\\';
+            if (ch >= 0 && ch < ' ') continue;
+            result += ch;
+        }
+        return result + "\"";
+    }
+
+    void writeJSON(ostream& out, const string& label, int repetitions, int numThreads,
+                   const vector<Measurement>& results) {
+        out << "{" << endl;
+        out << "  \"label\": "       << jsonString(label) << "," << endl;
+        out << "  \"repetitions\": " << repetitions       << "," << endl;
+        out << "  \"threads\": "     << numThreads        << "," << endl;
+        out << "  \"stats\": "       << (kStatsEnabled? "true" : "false") << "," << endl;
+        out << "  \"maps\": [" << endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const auto& entry = results[i];
+            out << "    { \"file\": "   << jsonString(entry.file)
+                << ", \"cities\": "     << entry.numCities
+                << ", \"roads\": "      << entry.numRoads
+                << ", \"optimal\": "    << entry.optimal
+                << ", \"median_seconds\": " << entry.seconds.median
+                << ", \"p95_seconds\": "    << entry.seconds.p95
+                << ", \"nodes\": "      << entry.nodes
+                << ", \"peak_bytes\": " << entry.peakBytes
+                << " }" << (i + 1 == results.size()? "" : ",") << endl;
+        }
+        out << "  ]" << endl;
+        out << "}" << endl;
+    }
+
+    void runBenchmarks() {
+        cout << "Disaster Planning Benchmarks" << endl;
+        if (!kStatsEnabled) {
+            cout << "Note: node counts need DISASTER_ENABLE_STATS (see the .pro file)." << endl;
+        }
+
+        int repetitions = getIntegerBetween("How many times should each map be solved? ", 1, 1000);
+        int numThreads = getIntegerBetween("How many threads (1 for the sequential solver)? ", 1, 256);
+        bool includeSlow = getYesOrNo("Include the VeryHard and VirtuallyImpossible maps? ");
+        string label = getLine("Label for this run (for example, a commit hash): ");
+
+        vector<Measurement> results;
+        for (const string& file: benchmarkFiles(includeSlow)) {
+            cout << "  " << left << setw(32) << file << flush;
+            results.push_back(measure(file, repetitions, numThreads));
+
+            const auto& entry = results.back();
+            cout << "median " << fixed << setprecision(6) << entry.seconds.median << "s, "
+                 << "p95 "    << entry.seconds.p95 << "s" << defaultfloat;
+            if (entry.nodes >= 0) cout << ", " << entry.nodes << " nodes";
+            if (entry.peakBytes >= 0) cout << ", peak " << entry.peakBytes / 1024 << " KB";
+            cout << endl;
+        }
+
+        ofstream csv(kCSVFile), json(kJSONFile);
+        if (!csv || !json) error("Can't write benchmark results.");
+        csv  << setprecision(9);
+        json << setprecision(9);
+        writeCSV(csv, label, repetitions, numThreads, results);
+        writeJSON(json, label, repetitions, numThreads, results);
+        cout << "Results written to " << kCSVFile << " and " << kJSONFile << "." << endl;
+    }
+}
+
+CONSOLE_HANDLER("Disaster Planning Benchmarks") {
+    runBenchmarks();
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+
+STUDENT_TEST("Benchmark percentiles use the nearest-rank method.") {
+    EXPECT_EQUAL(percentile({ 3 }, 50), 3.0);
+    EXPECT_EQUAL(percentile({ 4, 1, 3, 2 }, 50), 2.0);
+    EXPECT_EQUAL(percentile({ 4, 1, 3, 2 }, 95), 4.0);
+
+    vector<double> samples;
+    for (int i = 1; i <= 100; i++) {
+        samples.push_back(i);
+    }
+    EXPECT_EQUAL(percentile(samples, 50), 50.0);
+    EXPECT_EQUAL(percentile(samples, 95), 95.0);
+    EXPECT_EQUAL(percentile(samples, 100), 100.0);
+}
+
+STUDENT_TEST("Benchmark CSV fields keep commas and quotes inside them.") {
+    EXPECT_EQUAL(csvField("plain"), "\"plain\"");
+    EXPECT_EQUAL(csvField("fast, maybe"), "\"fast, maybe\"");
+    EXPECT_EQUAL(csvField("the \"new\" one"), "\"the \"\"new\"\" one\"");
+}
@@ -0,0 +1,361 @@
+#include "DisasterBinary.h"
+#include "DisasterGenerator.h"
+#include "DisasterTrace.h"
+#include "GUI/MiniGUI.h"
+#include "error.h"
+#include "simpio.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+namespace {
+    const char kMagic[4] = { 'D', 'S', 'T', 'B' };
+
+    struct Header {
+        char     magic[4];
+        uint32_t version;
+        uint32_t numCities;
+        uint32_t reserved;   // Always zero
+        uint64_t numLinks;
+        uint64_t nameBytes;
+        uint64_t checksum;   // Of everything after the header
+    };
+
+    /* The format is little-endian, and rather than convert every number we just insist
+     * on running somewhere that is, which is everywhere this project builds.
+     */
+    void checkByteOrder() {
+        const uint32_t one = 1;
+        char first;
+        memcpy(&first, &one, 1);
+        if (first != 1) error("Binary maps are only supported on little-endian machines.");
+    }
+
+    /* 64-bit FNV-1a hash. It isn't cryptographic, but it catches truncated and
+     * damaged files.
+     */
+    const uint64_t kChecksumStart = 14695981039346656037ULL;
+
+    uint64_t checksumOf(const char* data, size_t length) {
+        uint64_t checksum = kChecksumStart;
+        for (size_t i = 0; i < length; i++) {
+            checksum = (checksum ^ uint8_t(data[i])) * 1099511628211ULL;
+        }
+        return checksum;
+    }
+
+    /* Number of bytes the parts of a binary map after the header take up. */
+    uint64_t bodyBytes(uint64_t numCities, uint64_t numLinks, uint64_t nameBytes) {
+        return 2 * (numCities + 1) * sizeof(uint64_t) + numLinks * sizeof(uint32_t) +
+               2 * numCities * sizeof(float) + nameBytes;
+    }
+
+    /* Appends an array's bytes to the body being built. */
+    template <typename T> void append(string& body, const vector<T>& values) {
+        body.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+}
+
+void writeBinaryDisaster(ostream& out, const DisasterTest& test) {
+    checkByteOrder();
+    Vector<string> cities = test.network.keys();
+    if (uint64_t(cities.size()) >= UINT32_MAX) error("Network is too large for a binary map.");
+
+    unordered_map<string, uint32_t> ids;
+    for (int city = 0; city < cities.size(); city++) {
+        ids[cities[city]] = city;
+    }
+
+    vector<uint64_t> nameOffsets = { 0 }, linkOffsets = { 0 };
+    vector<uint32_t> links;
+    vector<float> coordinates;
+    string names;
+    for (const string& city: cities) {
+        names += city;
+        nameOffsets.push_back(names.size());
+
+        /* Sets iterate in sorted order, the same order cities are numbered in. */
+        for (const string& dest: test.network[city]) {
+            auto itr = ids.find(dest);
+            if (itr == ids.end()) error("Road from " + city + " leads to nonexistent city " + dest + ".");
+            if (!test.network[dest].contains(city)) error("Road from " + city + " to " + dest + " has no road back.");
+            links.push_back(itr->second);
+        }
+        linkOffsets.push_back(links.size());
+
+        GPoint location = test.cityLocations[city];
+        if (float(location.x) != location.x || float(location.y) != location.y) {
+            error("The location of " + city + " can't be stored exactly in a binary map.");
+        }
+        coordinates.push_back(float(location.x));
+        coordinates.push_back(float(location.y));
+    }
+
+    string body;
+    body.reserve(bodyBytes(cities.size(), links.size(), names.size()));
+    append(body, nameOffsets);
+    append(body, linkOffsets);
+    append(body, links);
+    append(body, coordinates);
+    body += names;
+
+    Header header;
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version   = kBinaryVersion;
+    header.numCities = cities.size();
+    header.reserved  = 0;
+    header.numLinks  = links.size();
+    header.nameBytes = names.size();
+    header.checksum  = checksumOf(body.data(), body.size());
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(body.data(), body.size());
+    if (!out) error("Can't write binary map.");
+}
+
+BinaryDisaster::BinaryDisaster(const string& filename) : file(filename) {
+    TRACE_SCOPE("BinaryDisaster");
+    checkByteOrder();
+    string_view contents = file.contents();
+
+    Header header;
+    if (contents.size() < sizeof(header)) error(filename + " is not a binary map.");
+    memcpy(&header, contents.data(), sizeof(header));
+    if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) error(filename + " is not a binary map.");
+    if (header.version != kBinaryVersion) {
+        error(filename + " is from version " + to_string(header.version) + " of the binary format, not version " +
+              to_string(kBinaryVersion) + ".");
+    }
+
+    /* Everything has to be the right size and hash to the right value... */
+    const char* body = contents.data() + sizeof(header);
+    uint64_t length = contents.size() - sizeof(header);
+    if (header.reserved != 0 || header.numCities == UINT32_MAX || header.numLinks > length || header.nameBytes > length ||
+        bodyBytes(header.numCities, header.numLinks, header.nameBytes) != length ||
+        checksumOf(body, length) != header.checksum) {
+        error(filename + " is damaged.");
+    }
+
+    cityCount   = header.numCities;
+    nameOffsets = reinterpret_cast<const uint64_t*>(body);
+    linkOffsets = nameOffsets + cityCount + 1;
+    links       = reinterpret_cast<const uint32_t*>(linkOffsets + cityCount + 1);
+    coordinates = reinterpret_cast<const float*>(links + header.numLinks);
+    names       = reinterpret_cast<const char*>(coordinates + 2 * cityCount);
+
+    /* ... and it has to describe a network the way loadDisaster would, so a file crafted
+     * to pass those checks can't lead anything astray: every offset in range, names in
+     * strictly increasing order, and each city's links in strictly increasing order,
+     * with every road listed in both directions.
+     */
+    bool valid = nameOffsets[0] == 0 && nameOffsets[cityCount] == header.nameBytes &&
+                 linkOffsets[0] == 0 && linkOffsets[cityCount] == header.numLinks;
+    for (uint32_t city = 0; valid && city < cityCount; city++) {
+        valid = nameOffsets[city] <= nameOffsets[city + 1] && linkOffsets[city] <= linkOffsets[city + 1];
+    }
+    for (uint64_t link = 0; valid && link < header.numLinks; link++) {
+        valid = links[link] < cityCount;
+    }
+    for (uint32_t city = 1; valid && city < cityCount; city++) {
+        valid = nameOf(city - 1) < nameOf(city);
+    }
+    for (uint32_t city = 0; valid && city < cityCount; city++) {
+        for (auto link = linksBegin(city); valid && link != linksEnd(city); link++) {
+            valid = (link == linksBegin(city) || *(link - 1) < *link) &&
+                    binary_search(linksBegin(*link), linksEnd(*link), city);
+        }
+    }
+    if (!valid) error(filename + " is damaged.");
+}
+
+DisasterTest BinaryDisaster::toTest() const {
+    TRACE_SCOPE("toTest");
+    DisasterTest result;
+
+    vector<string> cities;
+    for (int city = 0; city < numCities(); city++) {
+        cities.emplace_back(nameOf(city));
+    }
+    for (int city = 0; city < numCities(); city++) {
+        Set<string>& roads = result.network[cities[city]];
+        for (auto link = linksBegin(city); link != linksEnd(city); link++) {
+            roads += cities[*link];
+        }
+        result.cityLocations[cities[city]] = locationOf(city);
+    }
+    return result;
+}
+
+DisasterGraph BinaryDisaster::toGraph() const {
+    TRACE_SCOPE("toGraph");
+    DisasterGraph result;
+
+    result.offsets.reserve(numCities() + 1);
+    result.offsets.push_back(0);
+    for (int city = 0; city < numCities(); city++) {
+        result.names += string(nameOf(city));
+
+        /* toGraph drops roads from a city to itself. */
+        for (auto link = linksBegin(city); link != linksEnd(city); link++) {
+            if (int(*link) != city) result.neighbors.push_back(*link);
+        }
+        result.offsets.push_back(int(result.neighbors.size()));
+    }
+    return result;
+}
+
+namespace {
+    /* Converts a .dst file to a binary map, or the other way around. */
+    void convertMap() {
+        cout << "Convert Disaster Maps" << endl;
+        string source = trim(getLine(string("File to convert (.dst or ") + kBinarySuffix + "): "));
+
+        string destination;
+        if (endsWith(source, kBinarySuffix)) {
+            destination = source.substr(0, source.size() - strlen(kBinarySuffix)) + ".dst";
+            DisasterTest test = BinaryDisaster(source).toTest();
+
+            ofstream output(destination);
+            if (!output) error("Can't write to " + destination + ".");
+            writeDisaster(output, test);
+        } else if (endsWith(source, ".dst")) {
+            destination = source + "b";
+            DisasterTest test = loadDisasterFile(source);
+
+            ofstream output(destination, ios::binary);
+            if (!output) error("Can't write to " + destination + ".");
+            writeBinaryDisaster(output, test);
+        } else {
+            error(string("Can only convert .dst and ") + kBinarySuffix + " files.");
+        }
+        cout << "Converted " << source << " to " << destination << "." << endl;
+    }
+}
+
+CONSOLE_HANDLER("Convert Disaster Maps") {
+    convertMap();
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "filelib.h"
+#include <cstdio>
+#include <sstream>
+
+namespace {
+    const string kTestFile = string("disaster-binary-test") + kBinarySuffix;
+
+    void writeTestFile(const DisasterTest& test) {
+        ofstream output(kTestFile, ios::binary);
+        writeBinaryDisaster(output, test);
+    }
+}
+
+STUDENT_TEST("Binary maps load back as the maps they were made from.") {
+    const string kBasePath = "res/disaster-planning/";
+    for (const string& file: listDirectory(kBasePath)) {
+        if (!endsWith(file, ".dst")) continue;
+
+        DisasterTest test = loadDisasterFile(kBasePath + file);
+        writeTestFile(test);
+
+        BinaryDisaster binary(kTestFile);
+        EXPECT_EQUAL(binary.numCities(), test.network.size());
+
+        DisasterTest loaded = binary.toTest();
+        EXPECT_EQUAL(loaded.network, test.network);
+        EXPECT_EQUAL(loaded.cityLocations, test.cityLocations);
+
+        DisasterGraph graph = binary.toGraph(), expected = toGraph(test.network);
+        EXPECT_EQUAL(graph.names, expected.names);
+        EXPECT(graph.offsets == expected.offsets);
+        EXPECT(graph.neighbors == expected.neighbors);
+    }
+
+    /* Including ones with nothing in them, and with roads from a city to itself. */
+    DisasterTest empty;
+    writeTestFile(empty);
+    EXPECT_EQUAL(BinaryDisaster(kTestFile).numCities(), 0);
+
+    DisasterTest loop;
+    loop.network = { { "A", { "A", "B" } }, { "B", { "A" } } };
+    loop.cityLocations = { { "A", { 0, 0 } }, { "B", { 1.5, -2 } } };
+    writeTestFile(loop);
+    EXPECT_EQUAL(BinaryDisaster(kTestFile).toTest().network, loop.network);
+    EXPECT_EQUAL(BinaryDisaster(kTestFile).toGraph().neighbors.size(), 2);
+
+    remove(kTestFile.c_str());
+}
+
+STUDENT_TEST("Binary maps reject damaged files and inexact coordinates.") {
+    DisasterTest test;
+    test.network = { { "A", { "B" } }, { "B", { "A" } } };
+    test.cityLocations = { { "A", { 0, 0 } }, { "B", { 1, 1 } } };
+
+    ostringstream out;
+    writeBinaryDisaster(out, test);
+    string contents = out.str();
+
+    /* Damage to any byte is caught, as is cutting the file short. */
+    for (size_t byte = 0; byte < contents.size(); byte++) {
+        string damaged = contents;
+        damaged[byte] ^= 0x10;
+        ofstream(kTestFile, ios::binary) << damaged;
+        EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    }
+    ofstream(kTestFile, ios::binary) << contents.substr(0, contents.size() - 1);
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    ofstream(kTestFile, ios::binary) << "A (0, 0)\n";
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    remove(kTestFile.c_str());
+
+    test.cityLocations["B"] = { 0.1, 1 };
+    EXPECT_ERROR(writeBinaryDisaster(out, test));
+}
+
+STUDENT_TEST("Binary maps reject files that don't describe a network, checksum or no.") {
+    DisasterTest test;
+    test.network = { { "A", { "B", "C" } }, { "B", { "A" } }, { "C", { "A" } } };
+    test.cityLocations = { { "A", { 0, 0 } }, { "B", { 1, 1 } }, { "C", { 2, 0 } } };
+
+    ostringstream out;
+    writeBinaryDisaster(out, test);
+    const string contents = out.str();
+
+    /* Changes one byte, then fixes up the checksum so only the structure is wrong. */
+    auto writeChanged = [&](size_t byte, char value) {
+        string changed = contents;
+        changed[byte] = value;
+
+        Header header;
+        memcpy(&header, changed.data(), sizeof(header));
+        header.checksum = checksumOf(changed.data() + sizeof(header), changed.size() - sizeof(header));
+        memcpy(&changed[0], &header, sizeof(header));
+        ofstream(kTestFile, ios::binary) << changed;
+    };
+
+    /* Names are the last bytes of the file, and links come right after the offsets. */
+    size_t names = contents.size() - 3;
+    size_t links = sizeof(Header) + 2 * 4 * sizeof(uint64_t);
+
+    writeChanged(names, 'A');     // No change at all
+    EXPECT_EQUAL(BinaryDisaster(kTestFile).numCities(), 3);
+
+    writeChanged(names, 'B');     // Names out of order
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    writeChanged(names + 1, 'A'); // Same name twice
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    writeChanged(links + 4, 0);   // A's links out of order
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    writeChanged(links, 2);       // A linked to C twice, and B's road to A has no road back
+    EXPECT_ERROR(BinaryDisaster(kTestFile).numCities());
+    remove(kTestFile.c_str());
+
+    /* Networks like that can't be written in the first place. */
+    test.network["C"] = {};
+    EXPECT_ERROR(writeBinaryDisaster(out, test));
+}
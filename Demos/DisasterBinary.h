@@ -0,0 +1,98 @@
+#ifndef DisasterBinary_Included
+#define DisasterBinary_Included
+
+#include "DisasterParser.h"
+#include "DisasterMappedFile.h"
+#include "DisasterGraph.h"
+#include "gtypes.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * A binary form of .dst files, for networks that get loaded over and over. Loading one
+ * involves no parsing: the file is mapped into memory and its arrays are used where
+ * they lie.
+ * <p>
+ * A binary map is laid out as follows, with all numbers little-endian:
+ *
+ *     Header       magic "DSTB", version, number of cities n, number of links m,
+ *                  total bytes of names, and a checksum of everything after the header
+ *     uint64[n+1]  where each city's name starts in the name table
+ *     uint64[n+1]  where each city's links start in the link array
+ *     uint32[m]    link array: the cities each city has roads to, in increasing order
+ *     float[2n]    each city's x and y coordinates
+ *     char[]       name table: every city's name, back to back
+ *
+ * Cities are numbered in alphabetical order, as in DisasterGraph. Each road appears
+ * twice in the link array, once in each direction.
+ */
+
+/* File extension for binary maps. It's a compile-time constant so that other files'
+ * globals can be built from it safely.
+ */
+constexpr const char* kBinarySuffix = ".dstb";
+
+/* Current version of the binary format. Files from other versions are rejected. */
+const std::uint32_t kBinaryVersion = 1;
+
+/**
+ * Writes a network in the binary format.
+ *
+ * @throws ErrorException If a coordinate can't be stored exactly as a float, a road
+ *         isn't listed in both directions, or the network is too large for the format.
+ */
+void writeBinaryDisaster(std::ostream& out, const DisasterTest& test);
+
+/**
+ * A binary map, mapped into memory and checked for damage.
+ */
+class BinaryDisaster {
+public:
+    /* Maps and checks the named file.
+     *
+     * @throws ErrorException If the file can't be read, isn't a binary map from this
+     *         version of the format, or is damaged.
+     */
+    explicit BinaryDisaster(const std::string& filename);
+
+    int numCities() const {
+        return int(cityCount);
+    }
+
+    /* Name of a city, pointing into the mapped file. */
+    std::string_view nameOf(int city) const {
+        return { names + nameOffsets[city], std::size_t(nameOffsets[city + 1] - nameOffsets[city]) };
+    }
+
+    GPoint locationOf(int city) const {
+        return { coordinates[2 * city], coordinates[2 * city + 1] };
+    }
+
+    /* Cities the given city has roads to, in increasing order. */
+    const std::uint32_t* linksBegin(int city) const {
+        return links + linkOffsets[city];
+    }
+    const std::uint32_t* linksEnd(int city) const {
+        return links + linkOffsets[city + 1];
+    }
+
+    /* The network as loadDisaster would have produced it. */
+    DisasterTest toTest() const;
+
+    /* The network as toGraph would have produced it, without going through the Map. */
+    DisasterGraph toGraph() const;
+
+private:
+    MappedFile file;
+
+    std::uint32_t        cityCount;
+    const std::uint64_t* nameOffsets;
+    const std::uint64_t* linkOffsets;
+    const std::uint32_t* links;
+    const float*         coordinates;
+    const char*          names;
+};
+
+#endif
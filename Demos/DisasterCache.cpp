@@ -0,0 +1,204 @@
+#include "DisasterCache.h"
+#include "error.h"
+#include "filelib.h"
+#include "strlib.h"
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+using namespace std;
+
+const string kDefaultCacheDirectory = "disaster-cache";
+
+namespace {
+    /* Bump this whenever the file format changes, invalidating old entries. Version 1
+     * entries wrote down a refuted budget without any search having refuted it.
+     */
+    const int kFormatVersion = 2;
+
+    const string kFileSuffix = ".sol";
+
+    /* 64-bit FNV-1a. */
+    const uint64_t kFNVOffset = 14695981039346656037ull;
+    const uint64_t kFNVPrime  = 1099511628211ull;
+
+    void hashBytes(uint64_t& hash, const string& bytes) {
+        for (unsigned char ch: bytes) {
+            hash = (hash ^ ch) * kFNVPrime;
+        }
+        /* Terminate each string so that, say, "AB" + "C" differs from "A" + "BC". */
+        hash = (hash ^ 0xFF) * kFNVPrime;
+    }
+
+    int numRoadsIn(const Map<string, Set<string>>& network) {
+        int result = 0;
+        for (const string& city: network) {
+            result += network[city].size();
+        }
+        return result;
+    }
+
+    string pathFor(const string& hash, const string& directory) {
+        return directory + "/" + hash + kFileSuffix;
+    }
+
+    /* Confirms a stored set of cities really covers the network. */
+    bool coversNetwork(const Map<string, Set<string>>& network, const Set<string>& locations) {
+        for (const string& city: locations) {
+            if (!network.containsKey(city)) return false;
+        }
+        for (const string& city: network) {
+            if (!locations.contains(city) && (locations * network[city]).isEmpty()) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+string networkHash(const Map<string, Set<string>>& network) {
+    /* Map and Set iterate in sorted order, so this visits everything in a canonical order. */
+    uint64_t hash = kFNVOffset;
+    for (const string& city: network) {
+        hashBytes(hash, city);
+        for (const string& neighbor: network[city]) {
+            hashBytes(hash, neighbor);
+        }
+        hashBytes(hash, "");
+    }
+
+    ostringstream result;
+    result << hex << setw(16) << setfill('0') << hash;
+    return result.str();
+}
+
+bool lookupSolution(const Map<string, Set<string>>& network,
+                    CachedSolution& solution,
+                    const string& directory) {
+    string hash = networkHash(network);
+    ifstream input(pathFor(hash, directory));
+    if (!input) return false;
+
+    /* Read the header, making sure it's for this exact network. A hash collision
+     * would also have to match on size and then survive the coverage check below.
+     */
+    string key, storedHash, method;
+    int version, numCities, numRoads, optimal, refuted;
+    if (!(input >> key >> version) || key != "version" || version != kFormatVersion) return false;
+    if (!(input >> key >> storedHash) || key != "hash" || storedHash != hash) return false;
+    if (!(input >> key >> numCities) || key != "cities" || numCities != network.size()) return false;
+    if (!(input >> key >> numRoads) || key != "roads" || numRoads != numRoadsIn(network)) return false;
+    if (!(input >> key >> optimal) || key != "optimal") return false;
+    if (!(input >> key >> refuted) || key != "refuted" || refuted < 0 || refuted != optimal - 1) return false;
+    if (!(input >> key) || key != "method" || !getline(input, method) || trim(method).empty()) return false;
+
+    CachedSolution result;
+    result.refutedBudget = refuted;
+    result.method = trim(method);
+    for (string line; getline(input, line); ) {
+        if (trim(line).empty()) continue;
+        if (!startsWith(line, "city ")) return false;
+        result.locations += line.substr(string("city ").size());
+    }
+
+    if (result.locations.size() != optimal || !coversNetwork(network, result.locations)) {
+        return false;
+    }
+
+    solution = result;
+    return true;
+}
+
+void storeSolution(const Map<string, Set<string>>& network,
+                   const CachedSolution& solution,
+                   const string& directory) {
+    if (solution.refutedBudget < 0 || solution.refutedBudget != solution.locations.size() - 1) {
+        error("A cached solution needs a refuted budget one below its size.");
+    }
+    if (trim(solution.method).empty()) {
+        error("A cached solution needs to say what refuted the smaller budget.");
+    }
+    if (!isDirectory(directory)) {
+        createDirectoryPath(directory);
+    }
+
+    string hash = networkHash(network);
+    ofstream output(pathFor(hash, directory));
+    if (!output) error("Can't write to the solution cache in " + directory + ".");
+
+    output << "version " << kFormatVersion                  << endl;
+    output << "hash "    << hash                            << endl;
+    output << "cities "  << network.size()                  << endl;
+    output << "roads "   << numRoadsIn(network)             << endl;
+    output << "optimal " << solution.locations.size()       << endl;
+    output << "refuted " << solution.refutedBudget          << endl;
+    output << "method "  << solution.method                 << endl;
+    for (const string& city: solution.locations) {
+        output << "city " << city << endl;
+    }
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <cstdio>
+
+STUDENT_TEST("Network hash depends on cities and roads.") {
+    Map<string, Set<string>> one = { { "A", { "B" } }, { "B", { "A" } } };
+    Map<string, Set<string>> two = { { "A", { "B" } }, { "B", { "A" } }, { "C", { } } };
+    Map<string, Set<string>> three = { { "AB", { } }, { "C", { } } };
+    Map<string, Set<string>> four = { { "A", { } }, { "BC", { } } };
+
+    EXPECT_EQUAL(networkHash(one), networkHash(one));
+    EXPECT_NOT_EQUAL(networkHash(one), networkHash(two));
+    EXPECT_NOT_EQUAL(networkHash(three), networkHash(four));
+}
+
+STUDENT_TEST("Solutions round-trip through the cache, and stale ones are ignored.") {
+    const string directory = "disaster-cache-test";
+    Map<string, Set<string>> network = {
+        { "A", { "B" } }, { "B", { "A", "C" } }, { "C", { "B" } }
+    };
+
+    CachedSolution solution;
+    solution.locations = { "B" };
+    solution.refutedBudget = 0;
+    solution.method = "bitset";
+    storeSolution(network, solution, directory);
+
+    CachedSolution found;
+    EXPECT(lookupSolution(network, found, directory));
+    EXPECT_EQUAL(found.locations, { "B" });
+    EXPECT_EQUAL(found.refutedBudget, 0);
+    EXPECT_EQUAL(found.method, "bitset");
+
+    /* Solutions without evidence aren't stored. */
+    CachedSolution unproven = solution;
+    unproven.refutedBudget = -1;
+    EXPECT_ERROR(storeSolution(network, unproven, directory));
+    unproven = solution;
+    unproven.method = "";
+    EXPECT_ERROR(storeSolution(network, unproven, directory));
+
+    /* Nor are they accepted from disk. */
+    string path = directory + "/" + networkHash(network) + ".sol";
+    {
+        ofstream output(path);
+        output << "version 2\nhash " << networkHash(network) << "\ncities 3\nroads 4\n"
+               << "optimal 1\nrefuted 0\nmethod \ncity B\n";
+    }
+    EXPECT(!lookupSolution(network, found, directory));
+
+    /* A changed network gets a different entry. */
+    network["D"] = {};
+    EXPECT(!lookupSolution(network, found, directory));
+
+    /* Entries that don't actually cover the network are rejected. */
+    solution.locations = { "A" };
+    storeSolution(network, solution, directory);
+    EXPECT(!lookupSolution(network, found, directory));
+
+    remove((directory + "/" + networkHash(network) + ".sol").c_str());
+    network.remove("D");
+    remove((directory + "/" + networkHash(network) + ".sol").c_str());
+    remove(directory.c_str());
+}
@@ -0,0 +1,55 @@
+#ifndef DisasterCache_Included
+#define DisasterCache_Included
+
+#include "set.h"
+#include "map.h"
+#include <string>
+
+/**
+ * A small on-disk store of optimal disaster plans, so that a network that has been
+ * solved once never needs to be solved again. Entries are keyed by a hash of the road
+ * network itself rather than by file name, so an edited file is automatically treated
+ * as a new network.
+ */
+
+/* Default directory, relative to the project, in which solutions are stored. */
+extern const std::string kDefaultCacheDirectory;
+
+/**
+ * An optimal solution along with the evidence that it's optimal: a search that was run
+ * to completion, without being cancelled, showing no smaller set of cities works.
+ */
+struct CachedSolution {
+    Set<std::string> locations; // An optimal set of cities
+    int refutedBudget = -1;     // Budget a finished search found infeasible; locations.size() - 1
+    std::string method;         // The engine that searched it, e.g. "bitset"
+};
+
+/**
+ * Returns a hash of a road network that depends only on its cities and roads, and not
+ * on the order in which they were read in.
+ */
+std::string networkHash(const Map<std::string, Set<std::string>>& network);
+
+/**
+ * Looks up a previously-stored solution for the given network. Entries that are
+ * malformed, from an older format, that don't actually cover the network, or that
+ * don't say which search ruled out the next smaller budget are ignored.
+ *
+ * @return Whether a valid solution was found.
+ */
+bool lookupSolution(const Map<std::string, Set<std::string>>& network,
+                    CachedSolution& solution,
+                    const std::string& directory = kDefaultCacheDirectory);
+
+/**
+ * Stores an optimal solution for the given network, replacing any old one.
+ *
+ * @throws ErrorException If the solution doesn't name the search that refuted a budget
+ *         one below its size.
+ */
+void storeSolution(const Map<std::string, Set<std::string>>& network,
+                   const CachedSolution& solution,
+                   const std::string& directory = kDefaultCacheDirectory);
+
+#endif
@@ -0,0 +1,259 @@
+#include "GUI/MiniGUI.h"
+#include "GUI/Timer.h"
+#include "DisasterGenerator.h"
+#include "DisasterSolvers.h"
+#include "simpio.h"
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+
+/* Differential testing for the disaster solvers. We generate random networks, find the
+ * fewest cities each solver mode needs to cover them, and check that every mode agrees
+ * with the reference recursive solver and that everything any mode returns really is a
+ * valid plan.
+ */
+namespace {
+    const string kCSVFile       = "disaster-fuzz.csv";
+    const string kFailurePrefix = "disaster-fuzz-failure-";
+
+    /* Networks are drawn with a random number of cities up to a maximum. Small ones can
+     * have lots of roads; medium ones are kept sparse, which is where the backtrackers
+     * have the hardest time.
+     */
+    const int    kSmallCities      = 12;
+    const double kMaxSmallDegree   = 5;
+    const double kMaxMediumDegree  = 3;
+
+    /* The reference solver is exponential and runs once per budget in a binary search,
+     * so networks much bigger than this never finish.
+     */
+    const int    kMaxFuzzCities    = 24;
+
+    struct FuzzOptions {
+        int      rounds    = 100;
+        int      maxCities = kMaxFuzzCities;
+        uint64_t seed      = 0;
+    };
+
+    /* How one solver mode did on one network. */
+    struct ModeOutcome {
+        int    minimum = -1;   // Fewest cities it needed
+        double seconds = 0;    // Time to find that out
+        string problem;        // Description of anything it did wrong, if anything
+    };
+
+    /* Everything about one round. */
+    struct Round {
+        NetworkSpec spec;
+        int numRoads = 0;
+        vector<ModeOutcome> outcomes; // Parallel to allSolverModes()
+    };
+
+    struct FuzzReport {
+        vector<Round> rounds;
+        vector<int>   failures; // Indices of rounds where some mode misbehaved
+    };
+
+    /* Returns a description of what's wrong with a plan, or the empty string if it's
+     * a valid plan for the given budget.
+     */
+    string problemWith(const Map<string, Set<string>>& network,
+                       const Set<string>& plan, int budget) {
+        if (plan.size() > budget) {
+            return "used " + to_string(plan.size()) + " cities with a budget of " + to_string(budget);
+        }
+        for (const string& city: plan) {
+            if (!network.containsKey(city)) return "chose nonexistent city " + city;
+        }
+        for (const string& city: network) {
+            if (!plan.contains(city) && (plan * network[city]).isEmpty()) {
+                return "left " + city + " uncovered";
+            }
+        }
+        return "";
+    }
+
+    /* Finds the fewest cities the given solver mode needs, by binary search, checking
+     * every plan it returns along the way.
+     */
+    ModeOutcome runMode(const Map<string, Set<string>>& network, SolverMode mode) {
+        ModeOutcome result;
+
+        Timing::Timer timer;
+        timer.start();
+
+        int low = 0, high = network.size();
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            auto plan = placeEmergencySupplies(network, mid, mode);
+            if (plan != Nothing) {
+                string problem = problemWith(network, plan.value(), mid);
+                if (!problem.empty() && result.problem.empty()) result.problem = problem;
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+
+        timer.stop();
+        result.minimum = low;
+        result.seconds = timer.elapsed();
+        return result;
+    }
+
+    /* Picks the network for the next round. */
+    NetworkSpec randomSpec(mt19937_64& engine, int maxCities) {
+        NetworkSpec spec;
+        auto shapes = allNetworkShapes();
+        spec.shape     = shapes[engine() % shapes.size()];
+        spec.numCities = 1 + engine() % maxCities;
+
+        double maxDegree = spec.numCities <= kSmallCities? kMaxSmallDegree : kMaxMediumDegree;
+        spec.averageDegree = min(double(spec.numCities - 1) / 2, 1 + (engine() % 1000) / 1000.0 * (maxDegree - 1));
+        spec.seed = engine();
+        return spec;
+    }
+
+    FuzzReport fuzzSolvers(const FuzzOptions& options) {
+        mt19937_64 engine(options.seed);
+        auto modes = allSolverModes();
+
+        FuzzReport report;
+        for (int i = 0; i < options.rounds; i++) {
+            Round round;
+            round.spec = randomSpec(engine, options.maxCities);
+
+            auto network = generateDisaster(round.spec).network;
+            for (const string& city: network) {
+                round.numRoads += network[city].size();
+            }
+            round.numRoads /= 2;
+
+            bool failed = false;
+            for (SolverMode mode: modes) {
+                round.outcomes.push_back(runMode(network, mode));
+
+                const auto& outcome = round.outcomes.back();
+                if (!outcome.problem.empty() || outcome.minimum != round.outcomes[0].minimum) {
+                    failed = true;
+                }
+            }
+
+            if (failed) report.failures.push_back(i);
+            report.rounds.push_back(round);
+        }
+        return report;
+    }
+
+    /* Describes how a mode went wrong in the given round. */
+    string describeFailure(const Round& round, int modeIndex) {
+        const auto& outcome = round.outcomes[modeIndex];
+        if (!outcome.problem.empty()) return outcome.problem;
+        if (outcome.minimum != round.outcomes[0].minimum) {
+            return "needed " + to_string(outcome.minimum) + " cities, but " +
+                   nameOf(allSolverModes()[0]) + " needed " + to_string(round.outcomes[0].minimum);
+        }
+        return "";
+    }
+
+    void writeCSV(ostream& out, const FuzzReport& report) {
+        out << "round,shape,cities,roads,seed,minimum";
+        for (SolverMode mode: allSolverModes()) {
+            out << "," << nameOf(mode) << "_seconds";
+        }
+        out << endl;
+
+        for (size_t i = 0; i < report.rounds.size(); i++) {
+            const auto& round = report.rounds[i];
+            out << i << "," << nameOf(round.spec.shape) << "," << round.spec.numCities << ","
+                << round.numRoads << "," << round.spec.seed << "," << round.outcomes[0].minimum;
+            for (const auto& outcome: round.outcomes) {
+                out << "," << outcome.seconds;
+            }
+            out << endl;
+        }
+    }
+
+    void runFuzzer() {
+        cout << "Disaster Solver Fuzzing" << endl;
+
+        FuzzOptions options;
+        options.rounds    = getIntegerBetween("How many random networks? ", 1, 1000000);
+        options.maxCities = getIntegerBetween("Most cities in a network? ", 1, kMaxFuzzCities);
+        options.seed      = getInteger("Random seed? ");
+
+        FuzzReport report = fuzzSolvers(options);
+        auto modes = allSolverModes();
+
+        /* Report every discrepancy, saving the networks that caused them. */
+        for (int index: report.failures) {
+            const auto& round = report.rounds[index];
+            string filename = kFailurePrefix + to_string(index) + ".dst";
+            ofstream output(filename);
+            writeDisaster(output, generateDisaster(round.spec));
+
+            cout << "Round " << index << " (saved to " << filename << "):" << endl;
+            for (int mode = 0; mode < modes.size(); mode++) {
+                string failure = describeFailure(round, mode);
+                if (!failure.empty()) cout << "  " << nameOf(modes[mode]) << " " << failure << endl;
+            }
+        }
+
+        /* Summarize how fast each mode was compared with the reference. */
+        vector<double> totals(modes.size(), 0);
+        for (const auto& round: report.rounds) {
+            for (int mode = 0; mode < modes.size(); mode++) {
+                totals[mode] += round.outcomes[mode].seconds;
+            }
+        }
+
+        cout << report.rounds.size() << " networks, " << report.failures.size() << " with discrepancies." << endl;
+        for (int mode = 0; mode < modes.size(); mode++) {
+            cout << "  " << left << setw(12) << nameOf(modes[mode])
+                 << fixed << setprecision(4) << totals[mode] << "s total, "
+                 << setprecision(2) << totals[0] / max(totals[mode], 1e-9) << "x speedup"
+                 << defaultfloat << endl;
+        }
+
+        ofstream csv(kCSVFile);
+        if (!csv) error("Can't write fuzzing results.");
+        writeCSV(csv, report);
+        cout << "Per-network timings written to " << kCSVFile << "." << endl;
+    }
+}
+
+CONSOLE_HANDLER("Disaster Solver Fuzzing") {
+    runFuzzer();
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+
+STUDENT_TEST("Fuzzer catches plans that don't work.") {
+    Map<string, Set<string>> network = {
+        { "A", { "B" } }, { "B", { "A", "C" } }, { "C", { "B" } }, { "D", { } }
+    };
+    EXPECT_EQUAL(problemWith(network, { "B", "D" }, 2), "");
+    EXPECT_NOT_EQUAL(problemWith(network, { "B", "D" }, 1), "");
+    EXPECT_NOT_EQUAL(problemWith(network, { "B" }, 2), "");
+    EXPECT_NOT_EQUAL(problemWith(network, { "B", "E" }, 2), "");
+}
+
+STUDENT_TEST("All solver modes agree on random small and medium networks.") {
+    FuzzOptions options;
+    options.rounds    = 60;
+    options.maxCities = 20;
+    options.seed      = 106;
+
+    FuzzReport report = fuzzSolvers(options);
+    EXPECT_EQUAL(report.rounds.size(), 60);
+    for (int index: report.failures) {
+        for (int mode = 0; mode < allSolverModes().size(); mode++) {
+            EXPECT_EQUAL(describeFailure(report.rounds[index], mode), "");
+        }
+    }
+    EXPECT(report.failures.empty());
+}
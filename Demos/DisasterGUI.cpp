@@ -1,6 +1,9 @@
 #include "GUI/MiniGUI.h"
 #include "GUI/Color.h"
 #include "DisasterParser.h"
+#include "DisasterTrace.h"
+#include "DisasterOptimizer.h"
+#include "DisasterCache.h"
 #include "ginteractors.h"
 #include <fstream>
 #include <memory>
@@ -21,6 +24,9 @@ namespace {
     const string kProblemSuffix = ".dst";
     const string kBasePath = "res/disaster-planning/";
 
+    /* Where to write solver traces, in builds where tracing is enabled. */
+    const string kTraceFile = "disaster-trace.json";
+
     /* Background color. */
     const auto kBackgroundColor  = Color::BLACK();
 
@@ -294,38 +300,43 @@ namespace {
         return result;
     }
 
-    /* Uses binary search to find the optimal number of cities to use for disaster
-     * preparedness, populating the result field with the minimum group of cities
-     * that ended up being needed.
+    /* Finds an optimal solution, reusing the one from the solution cache if this network
+     * has been solved before, and saving it to the cache if not.
      */
-    void solveOptimally(const DisasterTest& test, Set<string>& result) {
-        /* The variable 'low' is the lowest number that might be feasible.
-         * The variable 'high' is the highest number that we know is feasible.
-         */
-        int low = 0, high = test.network.size();
+    void solveWithCache(const DisasterTest& test, Set<string>& result) {
+        CachedSolution cached;
+        if (lookupSolution(test.network, cached)) {
+            result = cached.locations;
+            return;
+        }
 
-        /* Begin with a feasible solution that uses as many cities as we'd like. */
-        auto returned = placeEmergencySupplies(test.network, high);
-        if (returned != Nothing) result = returned.value();
+        OptimalityProof proof = solveOptimallyInParallel(test, result);
 
-        while (low < high) {
-            /* This line looks weird, but it's designed to avoid integer overflows
-             * on large inputs. The idea that (high + low) can overflow, but
-             * (high - low) / 2 never will.
-             */
-            int mid = low + (high - low) / 2;
-            auto thisResult = placeEmergencySupplies(test.network, mid);
+        /* With no cities there's nothing to rule out, and nothing worth caching. */
+        if (proof.refutedBudget < 0) return;
 
-            /* If this option works, decrease high to it, since we know all is good. */
-            if (thisResult != Nothing) {
-                high = mid;
-                result = thisResult.value(); // Remember this result for later.
-            }
-            /* Otherwise, rule out anything less than or equal to it. */
-            else {
-                low = mid + 1;
-            }
-        }
+        cached.locations     = result;
+        cached.refutedBudget = proof.refutedBudget;
+        cached.method        = nameOf(proof.mode);
+        storeSolution(test.network, cached);
+    }
+
+    /* Begins a fresh trace of everything the solver does from here on. */
+    void beginTrace() {
+#ifdef DISASTER_ENABLE_TRACE
+        DisasterTrace::start();
+        DisasterTrace::setThreadName("Main");
+#endif
+    }
+
+    /* Stops tracing and saves what was recorded for viewing in Perfetto. */
+    void saveTrace() {
+#ifdef DISASTER_ENABLE_TRACE
+        DisasterTrace::stop();
+        ofstream output(kTraceFile);
+        DisasterTrace::writeJSON(output);
+        cout << "Solver trace written to " << kTraceFile << "." << endl;
+#endif
     }
 
     class DisasterGUI: public ProblemHandler {
@@ -386,10 +397,8 @@ namespace {
     }
 
     void DisasterGUI::loadWorld(const string& filename) {
-        ifstream input(kBasePath + filename);
-        if (!input) error("Cannot open file.");
-
-        mNetwork = loadDisaster(input);
+        beginTrace();
+        mNetwork = loadDisasterFile(kBasePath + filename);
         mSelected.clear();
         requestRepaint();
     }
@@ -402,7 +411,8 @@ namespace {
         mSolve->setEnabled(false);
         mProblems->setEnabled(false);
 
-        solveOptimally(mNetwork, mSelected);
+        solveWithCache(mNetwork, mSelected);
+        saveTrace();
 
         /* Enable controls. */
         mSolve->setEnabled(true);
@@ -442,14 +452,16 @@ namespace {
             ifstream input(makeFileSelection(".dst"));
             if (!input) error("Internal error - not your fault: Can't open the chosen file.");
 
+            beginTrace();
             auto scenario = loadDisaster(input);
 
             displayMap(scenario.network);
 
             cout << "Running your code to find the fewest number of cities needed... " << flush;
             Set<string> cities;
-            solveOptimally(scenario, cities);
+            solveWithCache(scenario, cities);
             cout << "done!" << endl;
+            saveTrace();
 
             displayBestCities(cities);
         } while (getYesOrNo("Try another demo file? "));
@@ -0,0 +1,515 @@
+#include "DisasterGenerator.h"
+#include "GUI/MiniGUI.h"
+#include "error.h"
+#include "simpio.h"
+#include "strlib.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <utility>
+#include <vector>
+using namespace std;
+
+namespace {
+    /* Most roads the generator will produce, to keep memory use in check. */
+    const long long kMaxGeneratedRoads = 20000000;
+
+    /* Random cities are placed on a lattice this many times finer than one with a cell
+     * per city, which leaves plenty of room for them to be at distinct locations.
+     */
+    const long long kLatticeSpread = 1024;
+
+    /* Source of random numbers. We use our own arithmetic on top of mt19937_64 rather
+     * than the standard distributions, whose results vary between standard libraries,
+     * so that a seed means the same thing everywhere.
+     */
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : engine(seed) {}
+
+        /* Uniformly random integer in [0, bound). Taking the engine's output mod bound
+         * would favor small results whenever bound doesn't divide 2^64, so we throw out
+         * the outputs below 2^64 mod bound, leaving a multiple of bound to choose from.
+         */
+        uint64_t below(uint64_t bound) {
+            uint64_t threshold = -bound % bound;
+            uint64_t value;
+            do {
+                value = engine();
+            } while (value < threshold);
+            return value % bound;
+        }
+
+    private:
+        mt19937_64 engine;
+    };
+
+    /* A network in its barest form: where each city is, and which pairs of cities are
+     * joined by roads.
+     */
+    struct Skeleton {
+        vector<GPoint> locations;
+        vector<pair<int, int>> roads; // Each road once, lower-numbered city first.
+    };
+
+    string cityName(int index) {
+        return "C" + to_string(index);
+    }
+
+    /* Unique key for an unordered pair of cities, lower-numbered city first. */
+    uint64_t keyFor(int from, int to, int numCities) {
+        return uint64_t(from) * numCities + to;
+    }
+
+    void addRoad(Skeleton& skeleton, int from, int to) {
+        skeleton.roads.push_back({ min(from, to), max(from, to) });
+    }
+
+    /* Side length of the lattice random cities are placed on. */
+    long long latticeSide(int numCities) {
+        return kLatticeSpread * max(1LL, (long long) ceil(sqrt(double(numCities))));
+    }
+
+    /* Removes duplicates from a list of keys, keeping the first copy of each. */
+    void removeDuplicates(vector<uint64_t>& keys) {
+        vector<pair<uint64_t, size_t>> sorted;
+        for (size_t i = 0; i < keys.size(); i++) {
+            sorted.push_back({ keys[i], i });
+        }
+        sort(sorted.begin(), sorted.end());
+
+        vector<bool> duplicate(keys.size(), false);
+        for (size_t i = 1; i < sorted.size(); i++) {
+            if (sorted[i].first == sorted[i - 1].first) duplicate[sorted[i].second] = true;
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (!duplicate[i]) keys[kept++] = keys[i];
+        }
+        keys.resize(kept);
+    }
+
+    /* Draws the given number of distinct keys, each uniformly at random from those the
+     * draw function produces. Drawing everything in a batch and topping up after
+     * removing duplicates is much faster than checking each draw against a hash set,
+     * and picks the same keys as drawing one at a time until there are enough.
+     */
+    template <typename Draw>
+    vector<uint64_t> distinctKeys(size_t count, Draw draw) {
+        vector<uint64_t> result;
+        while (result.size() < count) {
+            while (result.size() < count) {
+                result.push_back(draw());
+            }
+            removeDuplicates(result);
+        }
+        return result;
+    }
+
+    /* Places each city at a random, distinct lattice point. */
+    void placeRandomly(Skeleton& skeleton, int numCities, Random& random) {
+        uint64_t side = latticeSide(numCities);
+        for (uint64_t key: distinctKeys(numCities, [&] { return random.below(side * side); })) {
+            skeleton.locations.push_back({ double(key / side), double(key % side) });
+        }
+    }
+
+    /* Rows of cities, as close to square as possible. The last row may be partial. */
+    void makeGrid(Skeleton& skeleton, int numCities) {
+        int cols = max(1, int(ceil(sqrt(double(numCities)))));
+        for (int city = 0; city < numCities; city++) {
+            int row = city / cols, col = city % cols;
+            skeleton.locations.push_back({ double(col), double(row) });
+
+            if (col + 1 < cols && city + 1 < numCities) addRoad(skeleton, city, city + 1);
+            if (city + cols < numCities)                addRoad(skeleton, city, city + cols);
+        }
+    }
+
+    /* Joins every pair of cities within a fixed distance of one another, chosen so that
+     * the expected number of roads per city (ignoring edge effects) is the average
+     * degree. Nearby cities are found by bucketing cities into square cells at least as
+     * wide as that distance and checking only adjacent cells.
+     */
+    void makeGeometric(Skeleton& skeleton, int numCities, double averageDegree, Random& random) {
+        placeRandomly(skeleton, numCities, random);
+        if (numCities == 0 || averageDegree == 0) return;
+
+        long long side = latticeSide(numCities);
+        double radius = side * sqrt(averageDegree / (M_PI * numCities));
+        double cellSize = max(radius, double(kLatticeSpread));
+        int cellsPerSide = int(side / cellSize) + 1;
+
+        /* Counting sort of cities by cell. */
+        auto cellOf = [&](const GPoint& pt) {
+            return int(pt.x / cellSize) * cellsPerSide + int(pt.y / cellSize);
+        };
+        vector<int> cellStart(cellsPerSide * cellsPerSide + 1, 0);
+        for (const GPoint& pt: skeleton.locations) {
+            cellStart[cellOf(pt) + 1]++;
+        }
+        for (size_t i = 1; i < cellStart.size(); i++) {
+            cellStart[i] += cellStart[i - 1];
+        }
+        vector<int> byCell(numCities);
+        vector<int> next(cellStart.begin(), cellStart.end() - 1);
+        for (int city = 0; city < numCities; city++) {
+            byCell[next[cellOf(skeleton.locations[city])]++] = city;
+        }
+
+        for (int city = 0; city < numCities; city++) {
+            const GPoint& pt = skeleton.locations[city];
+            int cx = int(pt.x / cellSize), cy = int(pt.y / cellSize);
+
+            for (int x = max(cx - 1, 0); x <= min(cx + 1, cellsPerSide - 1); x++) {
+                for (int y = max(cy - 1, 0); y <= min(cy + 1, cellsPerSide - 1); y++) {
+                    int cell = x * cellsPerSide + y;
+                    for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                        int other = byCell[i];
+                        double dx = skeleton.locations[other].x - pt.x;
+                        double dy = skeleton.locations[other].y - pt.y;
+                        if (other > city && dx * dx + dy * dy <= radius * radius) {
+                            addRoad(skeleton, city, other);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /* Picks the right number of distinct roads uniformly at random. */
+    void makeErdosRenyi(Skeleton& skeleton, int numCities, double averageDegree, Random& random) {
+        placeRandomly(skeleton, numCities, random);
+
+        long long possible = (long long) numCities * (numCities - 1) / 2;
+        long long numRoads = llround(numCities * averageDegree / 2);
+        if (numRoads > possible) {
+            error("There can't be " + to_string(numRoads) + " roads between " +
+                  to_string(numCities) + " cities.");
+        }
+
+        /* If we want most of the possible roads, list them all and shuffle the ones we
+         * want to the front. This only happens for small networks.
+         */
+        if (2 * numRoads > possible) {
+            vector<pair<int, int>> all;
+            for (int from = 0; from < numCities; from++) {
+                for (int to = from + 1; to < numCities; to++) {
+                    all.push_back({ from, to });
+                }
+            }
+            for (long long i = 0; i < numRoads; i++) {
+                swap(all[i], all[i + random.below(all.size() - i)]);
+                skeleton.roads.push_back(all[i]);
+            }
+            return;
+        }
+
+        /* Otherwise, draw random roads and throw back any we've already got. */
+        auto draw = [&] {
+            while (true) {
+                int from = random.below(numCities);
+                int to   = random.below(numCities);
+                if (from != to) return keyFor(min(from, to), max(from, to), numCities);
+            }
+        };
+        for (uint64_t key: distinctKeys(numRoads, draw)) {
+            skeleton.roads.push_back({ int(key / numCities), int(key % numCities) });
+        }
+    }
+
+    /* Barabási–Albert preferential attachment. Starting from a handful of cities all
+     * joined to one another, each new city builds roads to a fixed number of distinct
+     * existing cities, each chosen with probability proportional to how many roads it
+     * already has. Picking a random endpoint of a random existing road does exactly that.
+     */
+    void makeScaleFree(Skeleton& skeleton, int numCities, double averageDegree, Random& random) {
+        placeRandomly(skeleton, numCities, random);
+
+        /* Each road adds two to the total degree. Every city after the first needs at
+         * least one road for the construction to work, so average degrees below 2 are
+         * treated as 2.
+         */
+        int perCity = max(1LL, llround(averageDegree / 2));
+        int numSeeds = min(numCities, perCity + 1);
+
+        vector<int> endpoints;
+        for (int from = 0; from < numSeeds; from++) {
+            for (int to = from + 1; to < numSeeds; to++) {
+                addRoad(skeleton, from, to);
+                endpoints.push_back(from);
+                endpoints.push_back(to);
+            }
+        }
+
+        vector<int> targets;
+        for (int city = numSeeds; city < numCities; city++) {
+            targets.clear();
+            while (int(targets.size()) < perCity) {
+                int target = endpoints[random.below(endpoints.size())];
+                if (find(targets.begin(), targets.end(), target) == targets.end()) {
+                    targets.push_back(target);
+                }
+            }
+
+            for (int target: targets) {
+                addRoad(skeleton, target, city);
+                endpoints.push_back(target);
+                endpoints.push_back(city);
+            }
+        }
+    }
+
+    Skeleton generateSkeleton(const NetworkSpec& spec) {
+        if (spec.numCities < 0 || spec.numCities > kMaxGeneratedCities) {
+            error("Number of cities must be between 0 and " + to_string(kMaxGeneratedCities) + ".");
+        }
+        if (spec.shape != NetworkShape::GRID) {
+            if (!(spec.averageDegree >= 0) || spec.averageDegree > spec.numCities) {
+                error("Average degree must be between 0 and the number of cities.");
+            }
+            if (spec.numCities * spec.averageDegree / 2 > kMaxGeneratedRoads) {
+                error("That network would have too many roads to generate.");
+            }
+        }
+
+        Skeleton result;
+        Random random(spec.seed);
+        switch (spec.shape) {
+            case NetworkShape::GRID:        makeGrid(result, spec.numCities); break;
+            case NetworkShape::GEOMETRIC:   makeGeometric (result, spec.numCities, spec.averageDegree, random); break;
+            case NetworkShape::ERDOS_RENYI: makeErdosRenyi(result, spec.numCities, spec.averageDegree, random); break;
+            case NetworkShape::SCALE_FREE:  makeScaleFree (result, spec.numCities, spec.averageDegree, random); break;
+            default: error("Unknown network shape.");
+        }
+
+        /* Sorting makes every city's list of roads come out in ascending order. */
+        sort(result.roads.begin(), result.roads.end());
+        return result;
+    }
+
+    /* Formats a coordinate so that the parser will accept it, which rules out
+     * scientific notation.
+     */
+    string formatCoordinate(double value) {
+        if (value == floor(value) && fabs(value) < 1e15) {
+            return to_string((long long) value);
+        }
+
+        ostringstream result;
+        result << fixed << setprecision(6) << value;
+
+        string text = result.str();
+        text.erase(text.find_last_not_of('0') + 1);
+        if (text.back() == '.') text.pop_back();
+        return text;
+    }
+
+    /* Writes one line of a .dst file. */
+    template <typename Names>
+    void writeCity(ostream& out, const string& name, const GPoint& location, const Names& links) {
+        out << name << " (" << formatCoordinate(location.x) << ", " << formatCoordinate(location.y) << "):";
+
+        bool first = true;
+        for (const string& link: links) {
+            out << (first? " " : ", ") << link;
+            first = false;
+        }
+        out << '\n';
+    }
+}
+
+Vector<NetworkShape> allNetworkShapes() {
+    return {
+        NetworkShape::GRID,
+        NetworkShape::GEOMETRIC,
+        NetworkShape::ERDOS_RENYI,
+        NetworkShape::SCALE_FREE,
+    };
+}
+
+string nameOf(NetworkShape shape) {
+    switch (shape) {
+        case NetworkShape::GRID:        return "grid";
+        case NetworkShape::GEOMETRIC:   return "random geometric";
+        case NetworkShape::ERDOS_RENYI: return "Erdos-Renyi";
+        case NetworkShape::SCALE_FREE:  return "scale-free";
+        default: break;
+    }
+    error("Unknown network shape.");
+    return "";
+}
+
+DisasterTest generateDisaster(const NetworkSpec& spec) {
+    Skeleton skeleton = generateSkeleton(spec);
+
+    vector<string> names;
+    DisasterTest result;
+    for (int city = 0; city < spec.numCities; city++) {
+        names.push_back(cityName(city));
+        result.network[names.back()] = {};
+        result.cityLocations[names.back()] = skeleton.locations[city];
+    }
+    for (const auto& road: skeleton.roads) {
+        result.network[names[road.first]]  += names[road.second];
+        result.network[names[road.second]] += names[road.first];
+    }
+    return result;
+}
+
+void writeGeneratedDisaster(ostream& out, const NetworkSpec& spec) {
+    Skeleton skeleton = generateSkeleton(spec);
+
+    out << "# Synthetic " << nameOf(spec.shape) << " network: " << spec.numCities << " cities, "
+        << skeleton.roads.size() << " roads, seed " << spec.seed << ".\n";
+    out << "# Each road is listed once; the parser adds the reverse direction.\n\n";
+
+    /* Roads are sorted, so each city's outgoing roads are contiguous. */
+    size_t road = 0;
+    vector<string> links;
+    for (int city = 0; city < spec.numCities; city++) {
+        links.clear();
+        for (; road < skeleton.roads.size() && skeleton.roads[road].first == city; road++) {
+            links.push_back(cityName(skeleton.roads[road].second));
+        }
+        writeCity(out, cityName(city), skeleton.locations[city], links);
+    }
+}
+
+void writeDisaster(ostream& out, const DisasterTest& test) {
+    for (const string& city: test.network) {
+        vector<string> links;
+        for (const string& link: test.network[city]) {
+            if (link > city) links.push_back(link);
+        }
+        writeCity(out, city, test.cityLocations[city], links);
+    }
+}
+
+namespace {
+    void generateMap() {
+        cout << "Generate Disaster Map" << endl;
+
+        Vector<string> shapes;
+        for (NetworkShape shape: allNetworkShapes()) {
+            shapes += nameOf(shape);
+        }
+
+        NetworkSpec spec;
+        spec.shape     = allNetworkShapes()[makeSelectionFrom("What shape of network?", shapes)];
+        spec.numCities = getIntegerBetween("How many cities? ", 0, kMaxGeneratedCities);
+        if (spec.shape != NetworkShape::GRID) {
+            spec.averageDegree = getReal("Average number of roads per city? ");
+        }
+        spec.seed = getInteger("Random seed? ");
+
+        string defaultName = "res/disaster-planning/Generated-" + stringReplace(nameOf(spec.shape), " ", "-") +
+                             "-" + to_string(spec.numCities) + "-" + to_string(spec.seed) + ".dst";
+        string filename = trim(getLine("File to write (leave blank for " + defaultName + "): "));
+        if (filename.empty()) filename = defaultName;
+
+        ofstream output(filename);
+        if (!output) error("Can't write to " + filename + ".");
+        writeGeneratedDisaster(output, spec);
+        cout << "Network written to " << filename << "." << endl;
+    }
+}
+
+CONSOLE_HANDLER("Generate Disaster Map") {
+    generateMap();
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "DisasterGrid.h"
+
+STUDENT_TEST("Generated .dst files load back as the generated network.") {
+    for (NetworkShape shape: allNetworkShapes()) {
+        for (int numCities: { 0, 1, 2, 7, 50 }) {
+            NetworkSpec spec;
+            spec.shape = shape;
+            spec.numCities = numCities;
+            spec.averageDegree = min(3.0, numCities / 2.0);
+            spec.seed = 137;
+
+            DisasterTest generated = generateDisaster(spec);
+            EXPECT_EQUAL(generated.network.size(), numCities);
+
+            stringstream file;
+            writeGeneratedDisaster(file, spec);
+            DisasterTest loaded = loadDisaster(file);
+            EXPECT_EQUAL(loaded.network, generated.network);
+            EXPECT_EQUAL(loaded.cityLocations, generated.cityLocations);
+
+            /* And the same goes for writing out an arbitrary network. */
+            stringstream copy;
+            writeDisaster(copy, generated);
+            EXPECT_EQUAL(loadDisaster(copy).network, generated.network);
+        }
+    }
+}
+
+STUDENT_TEST("Generated networks depend only on their seed.") {
+    for (NetworkShape shape: allNetworkShapes()) {
+        NetworkSpec spec;
+        spec.shape = shape;
+        spec.numCities = 200;
+        spec.seed = 1;
+
+        EXPECT_EQUAL(generateDisaster(spec).network, generateDisaster(spec).network);
+
+        if (shape != NetworkShape::GRID) {
+            NetworkSpec other = spec;
+            other.seed = 2;
+            EXPECT_NOT_EQUAL(generateDisaster(spec).network, generateDisaster(other).network);
+        }
+    }
+}
+
+STUDENT_TEST("Generated networks have the requested structure.") {
+    /* Square grids look like grids. */
+    NetworkSpec spec;
+    spec.numCities = 36;
+    DisasterGraph graph = toGraph(generateDisaster(spec).network);
+    GridLayout layout;
+    EXPECT(findGridLayout(graph, layout));
+    EXPECT_EQUAL(layout.rows * layout.cols, 36);
+
+    /* Erdos-Renyi networks have exactly the number of roads asked for. */
+    spec.shape = NetworkShape::ERDOS_RENYI;
+    spec.numCities = 1000;
+    spec.averageDegree = 5;
+    graph = toGraph(generateDisaster(spec).network);
+    EXPECT_EQUAL(graph.neighbors.size(), 5000);
+
+    /* The others get close. */
+    for (NetworkShape shape: { NetworkShape::GEOMETRIC, NetworkShape::SCALE_FREE }) {
+        spec.shape = shape;
+        spec.averageDegree = 6;
+        graph = toGraph(generateDisaster(spec).network);
+        EXPECT(graph.neighbors.size() > 4500);
+        EXPECT(graph.neighbors.size() < 7500);
+    }
+
+    /* Scale-free networks always give each new city at least one road. */
+    spec.shape = NetworkShape::SCALE_FREE;
+    spec.averageDegree = 0;
+    graph = toGraph(generateDisaster(spec).network);
+    EXPECT_EQUAL(graph.neighbors.size(), 2 * (1000 - 1));
+}
+
+STUDENT_TEST("Can write out a network with a million cities.") {
+    for (NetworkShape shape: { NetworkShape::GRID, NetworkShape::GEOMETRIC }) {
+        NetworkSpec spec;
+        spec.shape = shape;
+        spec.numCities = kMaxGeneratedCities;
+
+        ostringstream out;
+        EXPECT_COMPLETES_IN(10.0, writeGeneratedDisaster(out, spec));
+        EXPECT(out.str().size() > 10 * size_t(kMaxGeneratedCities));
+    }
+}
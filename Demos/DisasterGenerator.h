@@ -0,0 +1,65 @@
+#ifndef DisasterGenerator_Included
+#define DisasterGenerator_Included
+
+#include "DisasterParser.h"
+#include "vector.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Generator for synthetic road networks, for measuring how the solvers and the parser
+ * scale to networks far larger than the bundled maps. Cities are named C0, C1, C2, ...
+ * and placed at distinct integer coordinates.
+ */
+
+/* Kinds of networks that can be generated. */
+enum class NetworkShape {
+    GRID,         // Square lattice; each city joined to its horizontal and vertical neighbors.
+    GEOMETRIC,    // Random points, with roads between cities close enough together.
+    ERDOS_RENYI,  // Random points, with roads chosen uniformly at random.
+    SCALE_FREE,   // Preferential attachment: a few hub cities with very many roads.
+};
+
+/* All network shapes, in the order listed above. */
+Vector<NetworkShape> allNetworkShapes();
+
+/* Returns a human-readable name for a network shape. */
+std::string nameOf(NetworkShape shape);
+
+/* Largest network the generator will produce. */
+const int kMaxGeneratedCities = 1000000;
+
+/**
+ * Description of a network to generate. The same description always produces the same
+ * network, on every platform.
+ */
+struct NetworkSpec {
+    NetworkShape  shape         = NetworkShape::GRID;
+    int           numCities     = 100;  // Between 0 and kMaxGeneratedCities
+    double        averageDegree = 4;    // Roads per city, on average. Ignored for grids, and
+                                        // rounded to an even number, at least 2, for scale-free
+                                        // networks, which are always connected.
+    std::uint64_t seed          = 0;
+};
+
+/**
+ * Generates the network with the given description.
+ *
+ * @throws ErrorException If the description asks for something impossible.
+ */
+DisasterTest generateDisaster(const NetworkSpec& spec);
+
+/**
+ * Writes the network with the given description to a stream in the .dst format. This
+ * never builds the network as a DisasterTest, so it's the way to go for big networks.
+ * Loading what's written gives back exactly generateDisaster(spec).
+ */
+void writeGeneratedDisaster(std::ostream& out, const NetworkSpec& spec);
+
+/**
+ * Writes any network to a stream in the .dst format, listing each road once.
+ */
+void writeDisaster(std::ostream& out, const DisasterTest& test);
+
+#endif
@@ -0,0 +1,117 @@
+#include "GUI/MiniGUI.h"
+#include "GUI/Timer.h"
+#include "DisasterBinary.h"
+#include "DisasterGenerator.h"
+#include "DisasterParser.h"
+#include "error.h"
+#include "simpio.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+namespace {
+    /* Shape of the generated map. Random geometric networks have the usual mix of
+     * coordinate and road text, with names and coordinates of realistic lengths.
+     */
+    const NetworkShape kShape         = NetworkShape::GEOMETRIC;
+    const double       kAverageDegree = 4;
+
+    /* Median of some samples, which there must be at least one of. */
+    double median(vector<double> samples) {
+        sort(samples.begin(), samples.end());
+        return samples[(samples.size() - 1) / 2];
+    }
+
+    /* Where the generated map is written so it can be loaded from disk. */
+    const string kMapFile    = "disaster-load-benchmark.dst";
+    const string kBinaryFile = string("disaster-load-benchmark") + kBinarySuffix;
+
+    /* Loads a map the given number of times and reports how fast it went. */
+    void timeLoads(const string& label, int repetitions, size_t bytes, int numCities,
+                   const function<DisasterTest()>& load) {
+        vector<double> seconds;
+        for (int i = 0; i < repetitions; i++) {
+            Timing::Timer timer;
+            timer.start();
+            DisasterTest test = load();
+            timer.stop();
+
+            if (test.network.size() != numCities) error("Loaded the wrong number of cities.");
+            seconds.push_back(timer.elapsed());
+        }
+
+        double time = median(seconds);
+        cout << "  " << left << setw(16) << label
+             << "median " << fixed << setprecision(6) << time << "s, "
+             << "best " << *min_element(seconds.begin(), seconds.end()) << "s, "
+             << setprecision(1) << bytes / time / 1e6 << " MB/s, "
+             << setprecision(0) << numCities / time << " cities/s" << defaultfloat << endl;
+    }
+
+    /* Times loading a generated map: from a stream in memory, so disk speed doesn't
+     * enter into it; from a text file, the way the GUI does it; and from a binary map.
+     */
+    void runLoadBenchmarks() {
+        cout << "Disaster Map Loading Benchmarks" << endl;
+
+        NetworkSpec spec;
+        spec.shape         = kShape;
+        spec.averageDegree = kAverageDegree;
+        spec.numCities     = getIntegerBetween("How many cities in the generated map? ", 1, kMaxGeneratedCities);
+        int repetitions    = getIntegerBetween("How many times should it be loaded? ", 1, 1000);
+
+        ostringstream out;
+        writeGeneratedDisaster(out, spec);
+        string contents = out.str();
+        cout << "  Map is " << contents.size() / 1024 << " KB." << endl;
+
+        timeLoads("stream", repetitions, contents.size(), spec.numCities, [&] {
+            istringstream source(contents);
+            return loadDisaster(source);
+        });
+
+        {
+            ofstream file(kMapFile, ios::binary);
+            if (!(file << contents)) error("Can't write " + kMapFile + ".");
+        }
+        timeLoads("mapped file", repetitions, contents.size(), spec.numCities, [&] {
+            return loadDisasterFile(kMapFile);
+        });
+        timeLoads("parallel file", repetitions, contents.size(), spec.numCities, [&] {
+            return loadDisasterFileInParallel(kMapFile);
+        });
+
+        {
+            ofstream file(kBinaryFile, ios::binary);
+            writeBinaryDisaster(file, loadDisasterFile(kMapFile));
+        }
+        timeLoads("binary file", repetitions, contents.size(), spec.numCities, [&] {
+            return BinaryDisaster(kBinaryFile).toTest();
+        });
+
+        /* The solvers only need the graph, which a binary map gives without any Maps. */
+        vector<double> seconds;
+        for (int i = 0; i < repetitions; i++) {
+            Timing::Timer timer;
+            timer.start();
+            DisasterGraph graph = BinaryDisaster(kBinaryFile).toGraph();
+            timer.stop();
+            seconds.push_back(timer.elapsed());
+        }
+        cout << "  " << left << setw(16) << "binary graph"
+             << "median " << fixed << setprecision(6) << median(seconds) << "s" << defaultfloat << endl;
+
+        remove(kMapFile.c_str());
+        remove(kBinaryFile.c_str());
+    }
+}
+
+CONSOLE_HANDLER("Disaster Map Loading Benchmarks") {
+    runLoadBenchmarks();
+}
@@ -0,0 +1,80 @@
+#include "DisasterMappedFile.h"
+#include "error.h"
+using namespace std;
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const string& filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) error("Cannot open file " + filename + ".");
+
+    LARGE_INTEGER length;
+    if (!GetFileSizeEx(file, &length)) {
+        CloseHandle(file);
+        error("Cannot open file " + filename + ".");
+    }
+    size = size_t(length.QuadPart);
+
+    /* Empty files can't be mapped, but then there's nothing to map. */
+    if (size > 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+    CloseHandle(file);
+
+    if (size > 0 && data == nullptr) {
+        if (mapping != nullptr) CloseHandle(mapping);
+        error("Cannot map file " + filename + " into memory.");
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping != nullptr) CloseHandle(mapping);
+}
+
+#else
+
+MappedFile::MappedFile(const string& filename) {
+    int file = open(filename.c_str(), O_RDONLY);
+    if (file < 0) error("Cannot open file " + filename + ".");
+
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        close(file);
+        error("Cannot open file " + filename + ".");
+    }
+    size = size_t(info.st_size);
+
+    /* Empty files can't be mapped, but then there's nothing to map. */
+    if (size > 0) {
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapped == MAP_FAILED) {
+            close(file);
+            error("Cannot map file " + filename + " into memory.");
+        }
+        data = static_cast<const char*>(mapped);
+
+        /* Files are read front to back, so tell the OS to read ahead aggressively. */
+        madvise(mapped, size, MADV_SEQUENTIAL);
+    }
+    close(file);
+}
+
+MappedFile::~MappedFile() {
+    if (data != nullptr) munmap(const_cast<char*>(data), size);
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef DisasterMappedFile_Included
+#define DisasterMappedFile_Included
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * A file mapped read-only into memory, so its contents can be read in place without
+ * being copied into the program's own buffers. The operating system pages the file in
+ * as it's touched, which means even files larger than memory can be scanned through.
+ * <p>
+ * The contents stay valid for as long as the MappedFile does.
+ */
+class MappedFile {
+public:
+    /* Maps the named file.
+     *
+     * @throws ErrorException If the file can't be opened or mapped.
+     */
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    std::string_view contents() const {
+        return { data, size };
+    }
+
+private:
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+#if defined(_WIN32)
+    void* mapping = nullptr;  // Handle to the file mapping object
+#endif
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "DisasterOptimizer.h"
+#include "DisasterGrid.h"
+#include "DisasterSolvers.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+namespace {
+    /* Networks laid out on a grid can be solved optimally in one go, without
+     * searching over the number of cities. Returns whether that worked.
+     */
+    bool solveAsGrid(const DisasterTest& test, Set<string>& result, SearchStats* stats) {
+        DisasterGraph graph = toGraph(test.network);
+        GridLayout layout;
+        if (findGridLayout(graph, test.cityLocations, layout) || findGridLayout(graph, layout)) {
+            vector<int> chosen;
+            if (minimumGridCover(graph, layout, chosen, stats)) {
+                result = namesOf(graph, chosen);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* One budget being tried on a thread of its own. */
+    struct Probe {
+        int budget;
+        CancelFlag cancel { false };
+        bool done = false;
+        Optional<Set<string>> plan;
+        thread worker;
+    };
+}
+
+void solveOptimally(const DisasterTest& test, Set<string>& result, SearchStats* stats) {
+    TRACE_SCOPE("solveOptimally");
+    if (solveAsGrid(test, result, stats)) return;
+
+    /* The variable 'low' is the lowest number that might be feasible.
+     * The variable 'high' is the highest number that we know is feasible.
+     */
+    int low = 0, high = test.network.size();
+
+    /* Begin with a feasible solution that uses as many cities as we'd like. */
+    {
+        TRACE_SCOPE_VALUE("probe", "budget", high);
+        auto returned = placeEmergencySupplies(test.network, high, stats);
+        if (returned != Nothing) result = returned.value();
+    }
+
+    while (low < high) {
+        /* This line looks weird, but it's designed to avoid integer overflows
+         * on large inputs. The idea that (high + low) can overflow, but
+         * (high - low) / 2 never will.
+         */
+        int mid = low + (high - low) / 2;
+        TRACE_SCOPE_VALUE("probe", "budget", mid);
+        auto thisResult = placeEmergencySupplies(test.network, mid, stats);
+
+        /* If this option works, decrease high to it, since we know all is good. */
+        if (thisResult != Nothing) {
+            high = mid;
+            result = thisResult.value(); // Remember this result for later.
+        }
+        /* Otherwise, rule out anything less than or equal to it. */
+        else {
+            low = mid + 1;
+        }
+    }
+}
+
+OptimalityProof solveOptimallyInParallel(const DisasterTest& test, Set<string>& result,
+                                         int numThreads, SolverMode mode) {
+    TRACE_SCOPE("solveOptimallyInParallel");
+    if (mode == SolverMode::RECURSIVE) error("Parallel probes can't be cancelled in recursive mode.");
+
+    OptimalityProof proof;
+    if (solveAsGrid(test, result, nullptr)) {
+        proof.refutedBudget = result.size() - 1;
+        proof.mode = SolverMode::GRID;
+        return proof;
+    }
+
+    if (numThreads <= 0) numThreads = max(1, int(thread::hardware_concurrency()));
+
+    /* As in solveOptimally, every budget below 'low' is known not to work, and 'high'
+     * is known to work. Putting supplies everywhere always works.
+     */
+    int low = 0, high = test.network.size();
+    result.clear();
+    for (const string& city: test.network) {
+        result += city;
+    }
+
+    mutex lock;
+    condition_variable probeFinished;
+    vector<unique_ptr<Probe>> probes;
+
+    auto launch = [&](int budget) {
+        probes.emplace_back(new Probe);
+        Probe* probe = probes.back().get();
+        probe->budget = budget;
+        probe->worker = thread([&, probe] {
+            TRACE_THREAD_NAME("Probe");
+
+            Optional<Set<string>> plan;
+            {
+                TRACE_SCOPE_VALUE("probe", "budget", probe->budget);
+                plan = placeEmergencySupplies(test.network, probe->budget, mode, nullptr, &probe->cancel);
+            }
+
+            lock_guard<mutex> guard(lock);
+            probe->plan = plan;
+            probe->done = true;
+            probeFinished.notify_all();
+        });
+    };
+
+    unique_lock<mutex> guard(lock);
+    while (low < high) {
+        /* A probe outside of [low, high) can't tell us anything we don't know. Cancelled
+         * probes keep their threads until they notice, so they still count as running.
+         */
+        vector<int> fences = { low - 1, high };
+        int numRunning = 0;
+        for (const auto& probe: probes) {
+            if (probe->budget < low || probe->budget >= high) {
+                probe->cancel = true;
+            } else if (!probe->done) {
+                fences.push_back(probe->budget);
+            }
+            if (!probe->done) numRunning++;
+        }
+
+        /* Put idle threads to work, each new probe splitting the widest run of budgets
+         * nobody is looking at.
+         */
+        sort(fences.begin(), fences.end());
+        for (; numRunning < numThreads; numRunning++) {
+            int widest = 0;
+            for (int i = 1; i < int(fences.size()); i++) {
+                if (fences[i] - fences[i - 1] > fences[widest + 1] - fences[widest]) widest = i - 1;
+            }
+            if (fences[widest + 1] - fences[widest] < 2) break;
+
+            int budget = fences[widest] + (fences[widest + 1] - fences[widest]) / 2;
+            launch(budget);
+            fences.insert(fences.begin() + widest + 1, budget);
+        }
+
+        probeFinished.wait(guard, [&] {
+            return any_of(probes.begin(), probes.end(), [](const unique_ptr<Probe>& probe) {
+                return probe->done;
+            });
+        });
+
+        /* Learn what we can from finished probes. A plan is good even if its probe was
+         * cancelled, but a cancelled probe that found nothing tells us nothing.
+         */
+        for (auto& probe: probes) {
+            if (!probe->done) continue;
+            probe->worker.join();
+
+            if (probe->plan != Nothing) {
+                if (probe->budget < high) {
+                    high = probe->budget;
+                    result = probe->plan.value();
+                }
+            } else if (!probe->cancel && probe->budget >= low) {
+                low = probe->budget + 1;
+                proof.refutedBudget = probe->budget;
+                proof.mode = mode;
+            }
+        }
+        probes.erase(remove_if(probes.begin(), probes.end(), [](const unique_ptr<Probe>& probe) {
+            return probe->done;
+        }), probes.end());
+    }
+
+    /* Anything still running is now irrelevant. */
+    for (auto& probe: probes) {
+        probe->cancel = true;
+    }
+    guard.unlock();
+    for (auto& probe: probes) {
+        probe->worker.join();
+    }
+    return proof;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "DisasterGenerator.h"
+
+STUDENT_TEST("Parallel probing finds the same plans as sequential probing.") {
+    for (NetworkShape shape: { NetworkShape::GEOMETRIC, NetworkShape::ERDOS_RENYI, NetworkShape::SCALE_FREE }) {
+        for (int seed = 0; seed < 5; seed++) {
+            NetworkSpec spec;
+            spec.shape = shape;
+            spec.numCities = 18;
+            spec.averageDegree = 2.5;
+            spec.seed = seed;
+            DisasterTest test = generateDisaster(spec);
+
+            Set<string> sequential;
+            solveOptimally(test, sequential);
+
+            for (int numThreads: { 1, 2, 3, 8 }) {
+                Set<string> parallel;
+                solveOptimallyInParallel(test, parallel, numThreads, SolverMode::ITERATIVE);
+                EXPECT_EQUAL(parallel, sequential);
+            }
+
+            /* The other engines may pick different cities, but no more of them. */
+            for (SolverMode mode: { SolverMode::DANCING_LINKS, SolverMode::BITSET }) {
+                Set<string> parallel;
+                OptimalityProof proof = solveOptimallyInParallel(test, parallel, 3, mode);
+                EXPECT_EQUAL(parallel.size(), sequential.size());
+                for (const string& city: test.network) {
+                    EXPECT(parallel.contains(city) || !(parallel * test.network[city]).isEmpty());
+                }
+
+                /* The budget just below the plan really was tried, and really fails. */
+                EXPECT_EQUAL(proof.refutedBudget, parallel.size() - 1);
+                EXPECT(proof.mode == mode);
+                EXPECT_EQUAL(placeEmergencySupplies(test.network, proof.refutedBudget), Nothing);
+            }
+        }
+    }
+
+    /* Edge cases: nothing at all, and a city on its own. */
+    for (const DisasterTest& test: { DisasterTest(), DisasterTest{ { { "A", {} } }, { { "A", { 0, 0 } } } } }) {
+        Set<string> sequential, parallel;
+        solveOptimally(test, sequential);
+        OptimalityProof proof = solveOptimallyInParallel(test, parallel, 4);
+        EXPECT_EQUAL(parallel, sequential);
+        EXPECT_EQUAL(proof.refutedBudget, parallel.size() - 1);
+    }
+
+    /* The recursive solver can't be told to stop, so it can't be used for probes. */
+    Set<string> unused;
+    EXPECT_ERROR(solveOptimallyInParallel(DisasterTest(), unused, 1, SolverMode::RECURSIVE));
+}
@@ -0,0 +1,47 @@
+#ifndef DisasterOptimizer_Included
+#define DisasterOptimizer_Included
+
+#include "DisasterParser.h"
+#include "DisasterStats.h"
+#include "DisasterSolvers.h"
+#include "set.h"
+#include <string>
+
+/**
+ * Finds a smallest group of cities that covers the given network, populating result
+ * with it. Networks laid out on a grid are handed to the grid dynamic program;
+ * everything else is solved by binary searching over the number of cities with
+ * placeEmergencySupplies.
+ *
+ * If stats is non-null, the statistics of every search run along the way are added
+ * into it.
+ */
+void solveOptimally(const DisasterTest& test, Set<std::string>& result,
+                    SearchStats* stats = nullptr);
+
+/**
+ * Evidence that a plan is optimal: a budget one smaller than the plan that a search,
+ * run to completion without being cancelled, showed can't be met.
+ */
+struct OptimalityProof {
+    int refutedBudget = -1;  // The budget ruled out, or -1 if none had to be (no cities)
+    SolverMode mode = SolverMode::GRID;  // The engine that ruled it out
+};
+
+/**
+ * Same as solveOptimally, but probes several budgets at once on separate threads. Each
+ * probe's result narrows the range of budgets still in question; probes that fall
+ * outside that range are cancelled, and idle threads pick up new budgets in the largest
+ * unexplored stretch of it. The plan found uses as few cities as solveOptimally's,
+ * and with SolverMode::ITERATIVE it's the very same plan.
+ *
+ * @param numThreads How many probes to run at once, or 0 for one per hardware thread.
+ * @param mode       Which engine the probes use. It must be one that checks for
+ *                   cancellation, which rules out RECURSIVE.
+ * @return Which budget was shown infeasible, and by what. Grids are solved outright by
+ *         the grid dynamic program, which rules out every smaller plan at once.
+ */
+OptimalityProof solveOptimallyInParallel(const DisasterTest& test, Set<std::string>& result,
+                                         int numThreads = 0, SolverMode mode = SolverMode::BITSET);
+
+#endif
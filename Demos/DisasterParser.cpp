@@ -1,143 +1,546 @@
 #include "DisasterParser.h"
+#include "DisasterMappedFile.h"
+#include "DisasterSpatialHash.h"
+#include "DisasterTrace.h"
 #include "strlib.h"
-#include <regex>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <numeric>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 using namespace std;
 
 /* Everything in here is private to this file. */
 namespace {
-    enum NameComponents {
-        WholeString,
-        CityName,
-        XCoord,
-        YCoord,
-        NumComponents
+    bool isDigit(char ch) {
+        return ch >= '0' && ch <= '9';
+    }
+
+    /* Characters allowed in a city name. */
+    bool isNameChar(char ch) {
+        return (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || isDigit(ch) ||
+               ch == ' ' || ch == '.' || ch == '-';
+    }
+
+    /* What \s matches, and what trim removes. */
+    bool isSpace(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\v' || ch == '\f' || ch == '\r';
+    }
+
+    void skipSpaces(string_view text, size_t& pos) {
+        while (pos < text.size() && isSpace(text[pos])) pos++;
+    }
+
+    /* Like trim, but without making a copy. */
+    string_view trimmed(string_view text) {
+        size_t start = 0;
+        skipSpaces(text, start);
+
+        size_t end = text.size();
+        while (end > start && isSpace(text[end - 1])) end--;
+        return text.substr(start, end - start);
+    }
+
+    /* Largest number of digits whose value is sure to be exactly representable as a double,
+     * and the powers of ten that are.
+     */
+    const int kMaxExactDigits = 15;
+    const double kExactPowersOfTen[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    /* Scans a number of the form -123 or -123.45 starting at pos, advancing past it and
+     * storing its value. Returns whether there was one.
+     *
+     * When the digits fit in a double exactly, the value is one exact division away, and
+     * that division rounds the same way stringToReal would. Longer numbers go through
+     * stringToReal itself.
+     */
+    bool scanNumber(string_view text, size_t& pos, double& value) {
+        size_t start = pos;
+        bool negative = pos < text.size() && text[pos] == '-';
+        if (negative) pos++;
+
+        long long digits = 0;
+        int numDigits = 0, numDecimals = 0;
+
+        if (pos == text.size() || !isDigit(text[pos])) return false;
+        for (; pos < text.size() && isDigit(text[pos]); pos++, numDigits++) {
+            if (numDigits < kMaxExactDigits) digits = digits * 10 + (text[pos] - '0');
+        }
+
+        if (pos < text.size() && text[pos] == '.') {
+            pos++;
+            if (pos == text.size() || !isDigit(text[pos])) return false;
+            for (; pos < text.size() && isDigit(text[pos]); pos++, numDigits++, numDecimals++) {
+                if (numDigits < kMaxExactDigits) digits = digits * 10 + (text[pos] - '0');
+            }
+        }
+
+        if (numDigits <= kMaxExactDigits) {
+            value = double(digits) / kExactPowersOfTen[numDecimals];
+            if (negative) value = -value;
+        } else {
+            value = stringToReal(string(text.substr(start, pos - start)));
+        }
+        return true;
+    }
+
+    /* A city's name and location, as written in the file. */
+    struct CityInfo {
+        string_view name;
+        GPoint location;
     };
 
     /* Given city information in the form
      *
      *     CityName (X, Y)
      *
-     * Parses out the name and the X/Y coordinate, returning the
-     * name, and filling in the DisasterTest with what's found.
+     * Parses out the name and the X/Y coordinate.
+     *
+     * This is a single pass over the text, accepting exactly what the pattern
+     *
+     *     ^([A-Za-z0-9 .\-]+)\(\s*(-?[0-9]+(?:\.[0-9]+)?)\s*,\s*(-?[0-9]+(?:\.[0-9]+)?)\s*\)$
+     *
+     * does, without the cost of building and running a regex on every line. The name
+     * returned points into the text given.
      */
-    string parseCity(const string& cityInfo, DisasterTest& result) {
-        /* Split on all the delimiters and confirm we've only got
-         * three components.
-         */
-        regex  pattern("^([A-Za-z0-9 .\\-]+)\\(\\s*(-?[0-9]+(?:\\.[0-9]+)?)\\s*,\\s*(-?[0-9]+(?:\\.[0-9]+)?)\\s*\\)$");
-        smatch components;
-        string toMatch = trim(cityInfo);
+    CityInfo scanCity(string_view cityInfo) {
+        string_view text = trimmed(cityInfo);
+        auto fail = [&] {
+            error("Can't parse this data; is it city info? " + string(cityInfo));
+        };
 
-        if (!regex_match(toMatch, components, pattern)) {
-            error("Can't parse this data; is it city info? " + cityInfo);
-        }
+        /* Name, then the open parenthesis right after it. */
+        size_t pos = 0;
+        while (pos < text.size() && isNameChar(text[pos])) pos++;
+        if (pos == 0 || pos == text.size() || text[pos] != '(') fail();
+        size_t nameEnd = pos++;
 
-        /* There are four components here, actually: the whole match,
-         * plus each subexpression we care about.
-         */
-        if (components.size() != NumComponents) {
-            error("Could not find all components?");
-        }
+        /* Coordinates, separated by a comma, with whitespace allowed around each. */
+        double x, y;
+        skipSpaces(text, pos);
+        if (!scanNumber(text, pos, x)) fail();
+        skipSpaces(text, pos);
+        if (pos == text.size() || text[pos] != ',') fail();
+        pos++;
+        skipSpaces(text, pos);
+        if (!scanNumber(text, pos, y)) fail();
+        skipSpaces(text, pos);
 
-        /* We're going to get back some extra leading or trailing
-         * whitespace here, so peel it off.
-         */
-        string name = trim(components[CityName]);
+        /* Close parenthesis, and nothing after it. */
+        if (pos == text.size() || text[pos] != ')' || pos + 1 != text.size()) fail();
+
+        /* The name may have trailing whitespace before the parenthesis, so peel it off. */
+        string_view name = trimmed(text.substr(0, nameEnd));
         if (name.empty()) error("City names can't be empty.");
 
-        /* Insert the city location */
-        result.cityLocations[name] = {
-            stringToReal(components[XCoord]),
-            stringToReal(components[YCoord])
-        };
+        return { name, { x, y } };
+    }
+
+    /* Given a graph, confirms all nodes are at distinct locations. If not, reports the
+     * first city, in alphabetical order, at the same location as one before it, along
+     * with the first city at that location.
+     */
+    void validateLocations(const DisasterTest& test) {
+        vector<string> cities;
+        vector<GPoint> locations;
+        cities.reserve(test.cityLocations.size());
+        locations.reserve(test.cityLocations.size());
+        for (const string& city: test.cityLocations) {
+            cities.push_back(city);
+            locations.push_back(test.cityLocations[city]);
+        }
 
-        /* Insert an entry for the city into the road network. */
-        result.network[name] = {};
-        return name;
+        vector<int> first = SpatialHash(locations).firstAtSameLocation();
+        for (size_t city = 0; city < cities.size(); city++) {
+            if (first[city] != int(city)) {
+                throw runtime_error(cities[city] + " is at the same location as " + cities[first[city]]);
+            }
+        }
     }
 
-    /* Reads the links out of the back half of the line of a file,
-     * adding them to the road network.
+    /* A network as it's read, with each city referred to by number and each road listed
+     * in the direction it was written. Every name is stored once, and found again through
+     * views into that storage, so reading a line allocates nothing unless the line brings
+     * up a city not seen before.
      */
-    void parseLinks(const string& cityName, const string& linksStr,
-                    DisasterTest& result) {
-        /* It's possible that there are no outgoing links. */
-        if (trim(linksStr) == "") {
-            result.network[cityName] = {};
-            return;
+    class NetworkBuilder {
+    public:
+        /* Number of the city with the given name, adding it if it's new. */
+        int idOf(string_view name) {
+            auto itr = ids.find(name);
+            if (itr != ids.end()) return itr->second;
+
+            names.emplace_back(name);
+            cities.emplace_back();
+            seenOnLine.push_back(0);
+            ids.emplace(names.back(), int(cities.size()) - 1);
+            return int(cities.size()) - 1;
+        }
+
+        /* Starts the line for the given city. As with loadDisaster, a city listed twice
+         * keeps only what its last line says.
+         */
+        void addCity(int city, const GPoint& location) {
+            cities[city].defined  = true;
+            cities[city].location = location;
+            cities[city].links.clear();
+            line++;
+        }
+
+        /* Adds a road out of the city whose line is being read. */
+        void addLink(int city, int dest) {
+            if (seenOnLine[dest] == line) {
+                error("City appears twice in outgoing list?");
+            }
+            seenOnLine[dest] = line;
+            cities[city].links.push_back(dest);
         }
 
-        auto components = stringSplit(linksStr, ",");
-        for (const string& dest: components) {
-            /* Clean up all whitespace and make sure that we didn't
-             * discover an empty entry.
+        /* The network read, with every road in both directions. */
+        DisasterTest build() const {
+            /* A road to a city with no line of its own is an error. loadDisaster has always
+             * reported the first such road in alphabetical order of the city it's from,
+             * then of the city it goes to.
              */
-            string cleanName = trim(dest);
-            if (cleanName.empty()) {
-                error("Blank name in list of outgoing cities?");
+            int missingFrom = -1, missingTo = -1;
+            for (size_t city = 0; city < cities.size(); city++) {
+                if (!cities[city].defined) continue;
+                for (int dest: cities[city].links) {
+                    if (!cities[dest].defined &&
+                        (missingFrom == -1 || make_pair(names[city], names[dest]) <
+                                              make_pair(names[missingFrom], names[missingTo]))) {
+                        missingFrom = city;
+                        missingTo = dest;
+                    }
+                }
+            }
+            if (missingFrom != -1) {
+                error("Outgoing link found to nonexistent city '" + names[missingTo] + "'");
             }
 
-            /* Confirm this isn't a dupe. */
-            if (result.network[cityName].contains(cleanName)) {
-                error("City appears twice in outgoing list?");
+            /* Renumber the cities alphabetically, the order the Maps keep them in. */
+            vector<int> order;
+            for (size_t city = 0; city < cities.size(); city++) {
+                if (cities[city].defined) order.push_back(city);
+            }
+            sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+                return names[lhs] < names[rhs];
+            });
+            vector<uint64_t> rank(cities.size());
+            for (size_t index = 0; index < order.size(); index++) {
+                rank[order[index]] = index;
+            }
+
+            /* Every road in both directions, as (from, to) packed into one number. Sorting
+             * and removing repeats leaves each city's neighbors together and in order.
+             */
+            vector<uint64_t> roads;
+            for (int city: order) {
+                for (int dest: cities[city].links) {
+                    roads.push_back(rank[city] << 32 | rank[dest]);
+                    roads.push_back(rank[dest] << 32 | rank[city]);
+                }
             }
+            sort(roads.begin(), roads.end());
+            roads.erase(unique(roads.begin(), roads.end()), roads.end());
 
-            result.network[cityName] += cleanName;
+            DisasterTest result;
+            size_t road = 0;
+            for (size_t index = 0; index < order.size(); index++) {
+                const string& name = names[order[index]];
+                Set<string>& links = result.network[name];
+                for (; road < roads.size() && (roads[road] >> 32) == index; road++) {
+                    links += names[order[roads[road] & UINT32_MAX]];
+                }
+                result.cityLocations[name] = cities[order[index]].location;
+            }
+            return result;
         }
-    }
 
-    /* Parses one line out of the file and updates the network with what
-     * it found. This will only add edges in the forward direction as
-     * a safety measure; edges are reversed later on.
+    private:
+        struct City {
+            bool defined = false;   // Whether the city has its own line
+            GPoint location;
+            vector<int> links;
+        };
+
+        deque<string> names;                 // Never moves its strings, so views stay valid
+        unordered_map<string_view, int> ids;
+        vector<City> cities;
+
+        /* Line on which each city last appeared as a link, to catch duplicates. */
+        vector<int> seenOnLine;
+        int line = 0;
+    };
+
+    /* Same as parseCityLine, for a line held as a view. Reports the city the line is
+     * for with onCity(name, location), then each city it has roads to, in order, with
+     * onLink(name). The names given point into the line.
      */
-    void parseCityLine(const string& line, DisasterTest& result) {
-        /* Search for a colon on the line. The split function will only return a
-         * single component if there are no outgoing links specified.
-         */
-        auto numColons = count(line.begin(), line.end(), ':');
-        if (numColons != 1) {
+    template <typename OnCity, typename OnLink>
+    void scanCityLine(string_view line, OnCity onCity, OnLink onLink) {
+        size_t colon = line.find(':');
+        if (colon == string_view::npos || line.find(':', colon + 1) != string_view::npos) {
             error("Each data line should have exactly one colon on it.");
         }
 
-        /* Split the line into the city name/location and the list
-         * of outgoing cities.
-         */
-        auto components = stringSplit(line, ":");
-        if (components.isEmpty()) {
-            error("Data line appears to have no city information.");
+        CityInfo info = scanCity(line.substr(0, colon));
+        onCity(info.name, info.location);
+
+        /* It's possible that there are no outgoing links. */
+        string_view links = line.substr(colon + 1);
+        if (trimmed(links).empty()) return;
+
+        /* Like stringSplit, ignore one trailing empty piece. */
+        if (links.back() == ',') links.remove_suffix(1);
+
+        for (size_t start = 0; start <= links.size(); ) {
+            size_t end = min(links.find(',', start), links.size());
+            string_view dest = trimmed(links.substr(start, end - start));
+            if (dest.empty()) {
+                error("Blank name in list of outgoing cities?");
+            }
+            onLink(dest);
+            start = end + 1;
         }
+    }
 
-        /* Create a dummy list of outgoing cities if one doesn't already exist. */
-        if (components.size() == 1) components.add({});
+    /* Calls fn(line) on each line of the text that isn't blank or a comment. */
+    template <typename Function> void forEachDataLine(string_view text, Function fn) {
+        for (size_t start = 0; start < text.size(); ) {
+            size_t end = min(text.find('\n', start), text.size());
+            string_view line = text.substr(start, end - start);
+            start = end + 1;
 
-        string name = parseCity(components[0], result);
+            /* Skip blank lines or comments. */
+            if (trimmed(line).empty() || line[0] == '#') continue;
 
-        parseLinks(name, components[1], result);
+            fn(line);
+        }
     }
 
-    /* Given a graph in which all forward edges have been added, adds
-     * the reverse edges to the graph.
+    /* Reads one data line into the builder. */
+    void scanLine(string_view line, NetworkBuilder& builder) {
+        int city = -1;
+        scanCityLine(line, [&](string_view name, const GPoint& location) {
+            city = builder.idOf(name);
+            builder.addCity(city, location);
+        }, [&](string_view dest) {
+            builder.addLink(city, builder.idOf(dest));
+        });
+    }
+
+    /* Passes one data line to a DisasterParser. The set of links seen on the line is
+     * passed in, so that one set's memory serves every line of a file.
      */
-    void addReverseEdges(DisasterTest& result) {
-        for (const string& source: result.network) {
-            for (const string& dest: result.network[source]) {
-                if (!result.network.containsKey(dest)) {
-                    error("Outgoing link found to nonexistent city '" + dest + "'");
-                }
-                result.network[dest] += source;
+    void parseLine(string_view line, DisasterParser& parser, unordered_set<string_view>& links) {
+        string_view city;
+        links.clear();
+        scanCityLine(line, [&](string_view name, const GPoint& location) {
+            city = name;
+            parser.onCity(name, location.x, location.y);
+        }, [&](string_view dest) {
+            if (!links.insert(dest).second) {
+                error("City appears twice in outgoing list?");
+            }
+            parser.onRoad(city, dest);
+        });
+    }
+
+    /* Files smaller than this are read by a single thread; splitting them up costs more
+     * than it saves.
+     */
+    const size_t kMinParallelBytes = 1 << 20;
+
+    /* Runs job(i) for each i in [0, count) across the given number of threads, one of
+     * which is the calling thread. Only the threads started here are renamed in traces.
+     */
+    template <typename Job> void runInParallel(int count, int numThreads, Job job) {
+        atomic<int> next(0);
+        auto work = [&] {
+            for (int i = next++; i < count; i = next++) {
+                job(i);
             }
+        };
+
+        vector<thread> threads;
+        for (int i = 1; i < min(numThreads, count); i++) {
+            threads.emplace_back([&] {
+                TRACE_THREAD_NAME("Loader");
+                work();
+            });
+        }
+        work();
+        for (thread& worker: threads) {
+            worker.join();
         }
     }
 
-    /* Given a graph, confirms all nodes are at distinct locations. */
-    void validateLocations(const DisasterTest& test) {
-        Map<GPoint, string> locations;
-        for (auto loc: test.cityLocations) {
-            if (locations.containsKey(test.cityLocations[loc])) {
-                throw runtime_error(loc + " is at the same location as " + locations[test.cityLocations[loc]]);
+    /* Runs job(i) for each i in [0, count) across the given number of threads, for jobs
+     * too small to hand out one at a time. Each thread takes a range of indices at once,
+     * with a few ranges per thread so that a slow one doesn't hold everything up.
+     */
+    const int kRangesPerThread = 4;
+
+    template <typename Job> void runRangesInParallel(int count, int numThreads, Job job) {
+        int numRanges = max(1, min(count, kRangesPerThread * numThreads));
+        runInParallel(numRanges, numThreads, [&](int range) {
+            int end = int(int64_t(count) * (range + 1) / numRanges);
+            for (int i = int(int64_t(count) * range / numRanges); i < end; i++) {
+                job(i);
+            }
+        });
+    }
+
+    /* Sorts the items using the given number of threads: each sorts a slice, and then
+     * the slices are merged in pairs, also in parallel, until one is left.
+     */
+    template <typename T, typename Less>
+    void sortInParallel(vector<T>& items, int numThreads, Less less) {
+        int numSlices = max(1, min(numThreads, int(items.size() / 1024)));
+        auto boundary = [&](int slice) {
+            return items.begin() + items.size() * slice / numSlices;
+        };
+
+        runInParallel(numSlices, numThreads, [&](int slice) {
+            sort(boundary(slice), boundary(slice + 1), less);
+        });
+        for (int width = 1; width < numSlices; width *= 2) {
+            runInParallel((numSlices + 2 * width - 1) / (2 * width), numThreads, [&](int pair) {
+                int first = 2 * width * pair;
+                if (first + width < numSlices) {
+                    inplace_merge(boundary(first), boundary(first + width),
+                                  boundary(min(first + 2 * width, numSlices)), less);
+                }
+            });
+        }
+    }
+
+    /* A table of names that several threads can add to at once. Names are spread over
+     * shards by hash, each with its own lock, so threads seldom wait for one another.
+     * While names are being added, each is known by a handle; once they're all in,
+     * finish() numbers them 0, 1, 2, ... . Names are views, so whatever they point into
+     * has to outlive the table.
+     */
+    class ConcurrentInternTable {
+    public:
+        explicit ConcurrentInternTable(int numShards) : shards(numShards) {}
+
+        /* Handle for the given name, adding it if it's new. */
+        uint64_t handleOf(string_view name) {
+            size_t shardIndex = hash<string_view>()(name) % shards.size();
+            Shard& shard = shards[shardIndex];
+
+            lock_guard<mutex> lock(shard.lock);
+            auto result = shard.ids.emplace(name, uint32_t(shard.names.size()));
+            if (result.second) shard.names.push_back(name);
+            return uint64_t(shardIndex) << 32 | result.first->second;
+        }
+
+        /* Numbers every name added, which must be all of them. */
+        void finish() {
+            starts.push_back(0);
+            for (const Shard& shard: shards) {
+                starts.push_back(starts.back() + int(shard.names.size()));
+                for (string_view name: shard.names) {
+                    names.push_back(name);
+                }
             }
-            locations[test.cityLocations[loc]] = loc;
         }
+
+        /* Number of the name with the given handle. */
+        int idOf(uint64_t handle) const {
+            return starts[handle >> 32] + int(handle & UINT32_MAX);
+        }
+
+        string_view nameOf(int id) const {
+            return names[id];
+        }
+
+        int size() const {
+            return int(names.size());
+        }
+
+    private:
+        struct Shard {
+            mutex lock;
+            unordered_map<string_view, uint32_t> ids;
+            vector<string_view> names;
+        };
+        deque<Shard> shards;  // Mutexes can't move, and a deque never moves them.
+
+        vector<int> starts;   // Number of the first name in each shard
+        vector<string_view> names;
+    };
+
+    /* What one thread reads from its share of the file. */
+    struct Chunk {
+        /* A line for a city, with its roads at links[firstLink .. lastLink). */
+        struct CityLine {
+            size_t   offset;     // Where the line starts in the file; later lines win
+            uint64_t city;       // Interned handles
+            GPoint   location;
+            size_t   firstLink, lastLink;
+        };
+
+        vector<CityLine> lines;
+        vector<uint64_t> links;
+
+        /* The first error in the chunk, if any, and where its line starts. */
+        size_t errorOffset = string_view::npos;
+        string error;
+    };
+
+    /* Reads the data lines in the given part of the file into the chunk. */
+    void scanChunk(string_view contents, size_t begin, size_t end,
+                   ConcurrentInternTable& table, Chunk& chunk) {
+        /* Line each name last appeared as a link on, to catch duplicates. */
+        unordered_map<uint64_t, size_t> seenOnLine;
+
+        size_t offset = 0;
+        try {
+            forEachDataLine(contents.substr(begin, end - begin), [&](string_view line) {
+                offset = line.data() - contents.data();
+                scanCityLine(line, [&](string_view name, const GPoint& location) {
+                    chunk.lines.push_back({ offset, table.handleOf(name), location,
+                                            chunk.links.size(), chunk.links.size() });
+                }, [&](string_view dest) {
+                    uint64_t handle = table.handleOf(dest);
+                    size_t& seen = seenOnLine[handle];
+                    if (seen == offset + 1) {
+                        error("City appears twice in outgoing list?");
+                    }
+                    seen = offset + 1;
+
+                    chunk.links.push_back(handle);
+                    chunk.lines.back().lastLink++;
+                });
+            });
+        } catch (const ErrorException& e) {
+            chunk.errorOffset = offset;
+            chunk.error = e.getMessage();
+        }
+    }
+
+    /* Where the chunks start: evenly spaced, then moved up to the start of a line. */
+    vector<size_t> chunkBoundaries(string_view contents, int numChunks) {
+        vector<size_t> result = { 0 };
+        for (int chunk = 1; chunk < numChunks; chunk++) {
+            size_t start = max(result.back(), contents.size() * chunk / numChunks);
+            size_t newline = start == 0? 0 : contents.find('\n', start - 1);
+            result.push_back(newline == string_view::npos? contents.size() : newline + 1);
+        }
+        result.push_back(contents.size());
+        return result;
     }
 }
 
@@ -150,16 +553,536 @@ namespace {
  * @throws ErrorException If an error occurs or the file is invalid.
  */
 DisasterTest loadDisaster(istream& source) {
-    DisasterTest result;
+    TRACE_SCOPE("loadDisaster");
+    NetworkBuilder builder;
 
     for (string line; getline(source, line); ) {
         /* Skip blank lines or comments. */
-        if (trim(line).empty() || startsWith(line, "#")) continue;
+        if (trimmed(line).empty() || line[0] == '#') continue;
 
-        parseCityLine(line, result);
+        scanLine(line, builder);
     }
 
-    addReverseEdges(result);
+    DisasterTest result = builder.build();
+    validateLocations(result);
+    return result;
+}
+
+DisasterTest loadDisasterFile(const string& filename) {
+    TRACE_SCOPE("loadDisasterFile");
+    MappedFile file(filename);
+
+    NetworkBuilder builder;
+    forEachDataLine(file.contents(), [&](string_view line) {
+        scanLine(line, builder);
+    });
+
+    DisasterTest result = builder.build();
     validateLocations(result);
     return result;
 }
+
+DisasterTest loadDisasterFileInParallel(const string& filename, int numThreads) {
+    TRACE_SCOPE("loadDisasterFileInParallel");
+    if (numThreads <= 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+    MappedFile file(filename);
+    string_view contents = file.contents();
+
+    /* Read the chunks, several per thread so that a slow one doesn't hold up the rest. */
+    int numChunks = contents.size() < kMinParallelBytes? 1 : 4 * numThreads;
+    vector<size_t> boundaries = chunkBoundaries(contents, numChunks);
+    vector<Chunk> chunks(numChunks);
+    ConcurrentInternTable table(4 * numThreads);
+    runInParallel(numChunks, numThreads, [&](int chunk) {
+        scanChunk(contents, boundaries[chunk], boundaries[chunk + 1], table, chunks[chunk]);
+    });
+
+    /* Reading stopped at the first bad line, so report that one. */
+    const Chunk* failed = nullptr;
+    for (const Chunk& chunk: chunks) {
+        if (chunk.errorOffset != string_view::npos && (!failed || chunk.errorOffset < failed->errorOffset)) {
+            failed = &chunk;
+        }
+    }
+    if (failed) error(failed->error);
+
+    table.finish();
+    int n = table.size();
+
+    /* A city listed more than once keeps only its last line. */
+    vector<atomic<size_t>> lastLine(n);
+    runInParallel(numChunks, numThreads, [&](int chunk) {
+        for (const auto& line: chunks[chunk].lines) {
+            atomic<size_t>& last = lastLine[table.idOf(line.city)];
+            for (size_t seen = last; seen < line.offset + 1 && !last.compare_exchange_weak(seen, line.offset + 1); ) {
+                /* Someone else got there first; try again against what they wrote. */
+            }
+        }
+    });
+
+    /* Gather the roads from each city's last line in both directions, along with the
+     * locations from those lines and any roads to cities that have no line.
+     */
+    vector<GPoint> locations(n);
+    vector<vector<pair<int, int>>> roads(numChunks), missing(numChunks);
+    runInParallel(numChunks, numThreads, [&](int chunk) {
+        for (const auto& line: chunks[chunk].lines) {
+            int city = table.idOf(line.city);
+            if (lastLine[city] != line.offset + 1) continue;
+
+            locations[city] = line.location;
+            for (size_t link = line.firstLink; link < line.lastLink; link++) {
+                int dest = table.idOf(chunks[chunk].links[link]);
+                if (lastLine[dest] == 0) {
+                    missing[chunk].push_back({ city, dest });
+                } else {
+                    roads[chunk].push_back({ city, dest });
+                    roads[chunk].push_back({ dest, city });
+                }
+            }
+        }
+    });
+
+    /* loadDisaster reports the first missing city in alphabetical order of the city
+     * linking to it, then of the missing city.
+     */
+    const pair<int, int>* worst = nullptr;
+    for (const auto& list: missing) {
+        for (const auto& road: list) {
+            if (!worst || make_pair(table.nameOf(road.first),  table.nameOf(road.second)) <
+                          make_pair(table.nameOf(worst->first), table.nameOf(worst->second))) {
+                worst = &road;
+            }
+        }
+    }
+    if (worst) {
+        error("Outgoing link found to nonexistent city '" + string(table.nameOf(worst->second)) + "'");
+    }
+
+    /* Put the cities in alphabetical order, the order the Maps keep them in. */
+    vector<int> order;
+    for (int city = 0; city < n; city++) {
+        if (lastLine[city] != 0) order.push_back(city);
+    }
+    sortInParallel(order, numThreads, [&](int lhs, int rhs) {
+        return table.nameOf(lhs) < table.nameOf(rhs);
+    });
+    int numCities = order.size();
+    vector<int> rank(n);
+    runRangesInParallel(numCities, numThreads, [&](int index) {
+        rank[order[index]] = index;
+    });
+
+    /* Check for cities in the same place the way loadDisaster does: the first city, in
+     * alphabetical order, at the same location as one before it, reported along with
+     * the first city at that location.
+     */
+    vector<int> byLocation(numCities);
+    iota(byLocation.begin(), byLocation.end(), 0);
+    auto location = [&](int index) {
+        return locations[order[index]];
+    };
+    auto sameLocation = [&](int lhs, int rhs) {
+        return location(lhs).x == location(rhs).x && location(lhs).y == location(rhs).y;
+    };
+    sortInParallel(byLocation, numThreads, [&](int lhs, int rhs) {
+        return make_tuple(location(lhs).x, location(lhs).y, lhs) < make_tuple(location(rhs).x, location(rhs).y, rhs);
+    });
+    atomic<int> firstClash(numCities);
+    runInParallel(numThreads, numThreads, [&](int slice) {
+        for (int i = max(1, numCities * slice / numThreads); i < numCities * (slice + 1) / numThreads; i++) {
+            if (sameLocation(byLocation[i], byLocation[i - 1]) &&
+                (i == 1 || !sameLocation(byLocation[i], byLocation[i - 2]))) {
+                for (int seen = firstClash; byLocation[i] < seen && !firstClash.compare_exchange_weak(seen, byLocation[i]); ) {
+                    /* Try again against what another thread wrote. */
+                }
+            }
+        }
+    });
+    if (firstClash != numCities) {
+        auto clash = find(byLocation.begin(), byLocation.end(), int(firstClash));
+        throw runtime_error(string(table.nameOf(order[*clash])) + " is at the same location as " +
+                            string(table.nameOf(order[*(clash - 1)])));
+    }
+
+    /* Bucket the roads by where they start, then sort and deduplicate each bucket. */
+    vector<atomic<int>> next(numCities + 1);
+    runInParallel(numChunks, numThreads, [&](int chunk) {
+        for (const auto& road: roads[chunk]) {
+            next[rank[road.first] + 1]++;
+        }
+    });
+    vector<int> offsets(numCities + 1);
+    for (int city = 0; city < numCities; city++) {
+        offsets[city + 1] = offsets[city] + next[city + 1];
+        next[city] = offsets[city];
+    }
+    vector<int> neighbors(offsets.back());
+    runInParallel(numChunks, numThreads, [&](int chunk) {
+        for (const auto& road: roads[chunk]) {
+            neighbors[next[rank[road.first]]++] = rank[road.second];
+        }
+    });
+
+    /* Build each city's Set on its own, in parallel, and only then put them in the Map. */
+    vector<string> names(numCities);
+    runRangesInParallel(numCities, numThreads, [&](int city) {
+        names[city] = string(table.nameOf(order[city]));
+    });
+    vector<Set<string>> links(numCities);
+    runRangesInParallel(numCities, numThreads, [&](int city) {
+        auto begin = neighbors.begin() + offsets[city], end = neighbors.begin() + offsets[city + 1];
+        sort(begin, end);
+        for (auto dest = begin; dest != end; dest++) {
+            if (dest == begin || *dest != *(dest - 1)) links[city] += names[*dest];
+        }
+    });
+
+    DisasterTest result;
+    for (int city = 0; city < numCities; city++) {
+        result.network[names[city]] = move(links[city]);
+        result.cityLocations[names[city]] = locations[order[city]];
+    }
+    return result;
+}
+
+void parseDisaster(istream& source, DisasterParser& parser) {
+    TRACE_SCOPE("parseDisaster");
+    unordered_set<string_view> links;
+    for (string line; getline(source, line); ) {
+        /* Skip blank lines or comments. */
+        if (trimmed(line).empty() || line[0] == '#') continue;
+
+        parseLine(line, parser, links);
+    }
+}
+
+void parseDisasterFile(const string& filename, DisasterParser& parser) {
+    TRACE_SCOPE("parseDisasterFile");
+    MappedFile file(filename);
+    unordered_set<string_view> links;
+    forEachDataLine(file.contents(), [&](string_view line) {
+        parseLine(line, parser, links);
+    });
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "DisasterGenerator.h"
+#include "filelib.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <regex>
+#include <sstream>
+
+namespace {
+    /* What parseCity did before it had its own scanner: the city name and location if the
+     * text is city info, or Nothing if it isn't.
+     */
+    Optional<pair<string, GPoint>> parseCityWithRegex(const string& cityInfo) {
+        regex  pattern("^([A-Za-z0-9 .\\-]+)\\(\\s*(-?[0-9]+(?:\\.[0-9]+)?)\\s*,\\s*(-?[0-9]+(?:\\.[0-9]+)?)\\s*\\)$");
+        smatch components;
+        string toMatch = trim(cityInfo);
+        if (!regex_match(toMatch, components, pattern)) return Nothing;
+
+        return make_pair(trim(components[1]), GPoint(stringToReal(components[2]), stringToReal(components[3])));
+    }
+
+    Optional<pair<string, GPoint>> parseCityWithScanner(const string& cityInfo) {
+        try {
+            CityInfo city = scanCity(cityInfo);
+            return make_pair(string(city.name), city.location);
+        } catch (const ErrorException&) {
+            return Nothing;
+        }
+    }
+}
+
+STUDENT_TEST("City info scanner accepts exactly what the old regex did.") {
+    const vector<string> valid = {
+        "A (1, 2)", "Los Angeles(-3.25,4)", "  St. Louis - East ( 0.5 , -0.125 )  ",
+        "X1(12345678901234567890.5, 0.1)", "Y (-0, 000123.4500)", "Z (\t1,\t2)\n",
+    };
+    for (const string& info: valid) {
+        EXPECT(parseCityWithScanner(info) != Nothing);
+        EXPECT(parseCityWithScanner(info) == parseCityWithRegex(info));
+    }
+
+    const vector<string> invalid = {
+        "", "(1, 2)", "A 1, 2)", "A (1 2)", "A (1, 2", "A (1, 2) x", "A (1., 2)", "A (.5, 2)",
+        "A (+1, 2)", "A (1e3, 2)", "A (--1, 2)", "A_B (1, 2)", "A (1, 2))", "A ((1, 2)",
+    };
+    for (const string& info: invalid) {
+        EXPECT(parseCityWithScanner(info) == Nothing);
+        EXPECT(parseCityWithRegex(info) == Nothing);
+    }
+
+    /* Random strings over the characters that matter, mostly near-misses of valid ones. */
+    mt19937_64 engine(1729);
+    const string alphabet = "Ab9 .-(,)\t0123456789_";
+    for (int round = 0; round < 2000; round++) {
+        string info = valid[engine() % valid.size()];
+        for (int edits = engine() % 4; edits > 0 && !info.empty(); edits--) {
+            size_t pos = engine() % info.size();
+            char ch = alphabet[engine() % alphabet.size()];
+            switch (engine() % 3) {
+                case 0:  info[pos] = ch;            break;
+                case 1:  info.insert(pos, 1, ch);   break;
+                default: info.erase(pos, 1);        break;
+            }
+        }
+        EXPECT(parseCityWithScanner(info) == parseCityWithRegex(info));
+    }
+}
+
+STUDENT_TEST("Mapped files load the same as streams do.") {
+    const string kBasePath = "res/disaster-planning/";
+    for (const string& file: listDirectory(kBasePath)) {
+        if (!endsWith(file, ".dst")) continue;
+
+        ifstream input(kBasePath + file);
+        DisasterTest streamed = loadDisaster(input);
+        DisasterTest mapped = loadDisasterFile(kBasePath + file);
+        EXPECT_EQUAL(mapped.network, streamed.network);
+        EXPECT_EQUAL(mapped.cityLocations, streamed.cityLocations);
+    }
+}
+
+namespace {
+    /* Files that are odd or malformed in ways the loaders have to agree on. */
+    const vector<string> kTrickyFiles = {
+        "",
+        "# Just a comment",
+        "A (0, 0): B,\r\nB (1, 1):\r\n",
+        "A (0, 0): B, C\nB (1, 1):\nC (2, 2):\nA (3, 3): C\n\n",
+        "A (0, 0): A",
+        "A (0, 0)",
+        "A (0, 0):",
+        "A (0, 0): B: C",
+        "A (0, 0): B, B\nB (1, 1):",
+        "A (0, 0): B, , C",
+        "A (0, 0): ,",
+        "A (0, 0): Z, B, Y\nB (1, 1): X",
+        "A (0, 0):\nB (0, 0):",
+        "A (0 0)",
+        ":",
+    };
+
+    /* Loads a network, returning the error message if there is one. */
+    string loadOrError(const function<DisasterTest()>& load, DisasterTest& result) {
+        try {
+            result = load();
+            return "";
+        } catch (const exception& e) {
+            return e.what();
+        }
+    }
+}
+
+STUDENT_TEST("Mapped files are checked the same way streams are.") {
+    const string filename = "disaster-parser-test.dst";
+    for (const string& contents: kTrickyFiles) {
+        ofstream(filename, ios::binary) << contents;
+
+        DisasterTest streamed, mapped;
+        string streamedError = loadOrError([&] {
+            istringstream input(contents);
+            return loadDisaster(input);
+        }, streamed);
+        string mappedError = loadOrError([&] {
+            return loadDisasterFile(filename);
+        }, mapped);
+
+        EXPECT_EQUAL(mappedError, streamedError);
+        EXPECT_EQUAL(mapped.network, streamed.network);
+        EXPECT_EQUAL(mapped.cityLocations, streamed.cityLocations);
+    }
+    remove(filename.c_str());
+
+    EXPECT_ERROR(loadDisasterFile("this-file-does-not-exist.dst"));
+}
+
+STUDENT_TEST("Parallel loading gives the same results and errors as sequential loading.") {
+    const string kBasePath = "res/disaster-planning/";
+    for (const string& file: listDirectory(kBasePath)) {
+        if (!endsWith(file, ".dst")) continue;
+
+        DisasterTest sequential = loadDisasterFile(kBasePath + file);
+        DisasterTest parallel = loadDisasterFileInParallel(kBasePath + file, 4);
+        EXPECT_EQUAL(parallel.network, sequential.network);
+        EXPECT_EQUAL(parallel.cityLocations, sequential.cityLocations);
+    }
+
+    /* Files only get split up once they're big, so pad out a generated network with
+     * comments, and put each tricky file at its start, middle, and end.
+     */
+    NetworkSpec spec;
+    spec.shape = NetworkShape::GEOMETRIC;
+    spec.numCities = 2000;
+    ostringstream generated;
+    writeGeneratedDisaster(generated, spec);
+
+    vector<string> lines;
+    istringstream input(generated.str());
+    for (string line; getline(input, line); ) {
+        lines.push_back(line + "\n# " + string(600, '.') + "\n");
+    }
+
+    const string filename = "disaster-parallel-test.dst";
+    for (const string& tricky: kTrickyFiles) {
+        for (size_t position: { size_t(0), lines.size() / 2, lines.size() }) {
+            string contents;
+            for (size_t line = 0; line <= lines.size(); line++) {
+                if (line == position) contents += tricky + "\n";
+                if (line < lines.size()) contents += lines[line];
+            }
+            ofstream(filename, ios::binary) << contents;
+
+            DisasterTest sequential;
+            string sequentialError = loadOrError([&] {
+                return loadDisasterFile(filename);
+            }, sequential);
+
+            for (int numThreads: { 1, 3, 8 }) {
+                DisasterTest parallel;
+                string parallelError = loadOrError([&] {
+                    return loadDisasterFileInParallel(filename, numThreads);
+                }, parallel);
+
+                EXPECT_EQUAL(parallelError, sequentialError);
+                EXPECT_EQUAL(parallel.network, sequential.network);
+                EXPECT_EQUAL(parallel.cityLocations, sequential.cityLocations);
+            }
+        }
+    }
+    remove(filename.c_str());
+}
+
+namespace {
+    /* Counts each city's roads, in both directions, without building the network. */
+    class DegreeCounter: public DisasterParser {
+    public:
+        Map<string, int> degrees;
+        int numRoads = 0;
+
+        void onCity(string_view name, double, double) override {
+            degrees[string(name)];
+        }
+        void onRoad(string_view from, string_view to) override {
+            degrees[string(from)]++;
+            degrees[string(to)]++;
+            numRoads++;
+        }
+    };
+
+    /* Writes everything it's told back out as a .dst file. */
+    class Echo: public DisasterParser {
+    public:
+        ostringstream out;
+        bool firstRoad = true;
+
+        void onCity(string_view name, double x, double y) override {
+            out << "\n" << name << " (" << x << ", " << y << "):";
+            firstRoad = true;
+        }
+        void onRoad(string_view, string_view to) override {
+            out << (firstRoad? " " : ", ") << to;
+            firstRoad = false;
+        }
+    };
+}
+
+STUDENT_TEST("Streaming parser reports each city and road as written.") {
+    NetworkSpec spec;
+    spec.shape = NetworkShape::SCALE_FREE;
+    spec.numCities = 500;
+    spec.seed = 106;
+    DisasterTest test = generateDisaster(spec);
+
+    /* Each road is written once, so the degrees counted are the true ones. */
+    stringstream file;
+    writeGeneratedDisaster(file, spec);
+    DegreeCounter counter;
+    parseDisaster(file, counter);
+    EXPECT_EQUAL(counter.degrees.size(), test.network.size());
+    for (const string& city: test.network) {
+        EXPECT_EQUAL(counter.degrees[city], test.network[city].size());
+    }
+
+    /* Writing back what's reported gives the same network, from a file or a stream. */
+    const string filename = "disaster-streaming-test.dst";
+    {
+        ofstream output(filename);
+        writeGeneratedDisaster(output, spec);
+    }
+    Echo echo;
+    parseDisasterFile(filename, echo);
+    istringstream copy(echo.out.str());
+    EXPECT_EQUAL(loadDisaster(copy).network, test.network);
+    remove(filename.c_str());
+}
+
+STUDENT_TEST("Streaming parser checks lines the way loadDisaster does.") {
+    for (const string& contents: kTrickyFiles) {
+        DisasterTest loaded;
+        string loadError = loadOrError([&] {
+            istringstream input(contents);
+            return loadDisaster(input);
+        }, loaded);
+
+        istringstream input(contents);
+        DegreeCounter counter;
+        string parseError;
+        try {
+            parseDisaster(input, counter);
+        } catch (const ErrorException& e) {
+            parseError = e.what();
+        }
+
+        /* Problems within a line are found the same way. Problems between lines
+         * aren't looked for.
+         */
+        if (!startsWith(loadError, "Outgoing link") && !endsWith(loadError, "same location as A")) {
+            EXPECT_EQUAL(parseError, loadError);
+        } else {
+            EXPECT_EQUAL(parseError, "");
+        }
+    }
+}
+
+STUDENT_TEST("Loaders add reverse roads and report errors as they always have.") {
+    auto load = [](const string& contents) {
+        istringstream input(contents);
+        return loadDisaster(input);
+    };
+
+    DisasterTest test = load("A (0, 0): B, C\nB (1, 1):\nC (2, 2): B\nA (3, 3): C\nD (4, 4): D, A\n");
+    Map<string, Set<string>> expected = {
+        { "A", { "C", "D" } }, { "B", { "C" } }, { "C", { "A", "B" } }, { "D", { "A", "D" } }
+    };
+    EXPECT_EQUAL(test.network, expected);
+    EXPECT_EQUAL(test.cityLocations["A"], GPoint(3, 3));
+
+    /* Roads listed from both ends are only there once. */
+    EXPECT_EQUAL(load("A (0, 0): B\nB (1, 1): A").network["A"], { "B" });
+
+    auto errorFrom = [&](const string& contents) {
+        try {
+            load(contents);
+        } catch (const exception& e) {
+            return string(e.what());
+        }
+        return string();
+    };
+    EXPECT_EQUAL(errorFrom("A (0, 0): Z, B, Y\nB (1, 1): X"), "Outgoing link found to nonexistent city 'Y'");
+    EXPECT_EQUAL(errorFrom("B (0, 0): Y\nA (1, 1): Z"),       "Outgoing link found to nonexistent city 'Z'");
+    EXPECT_EQUAL(errorFrom("C (0, 0):\nB (1, 1):\nA (0, 0):"),   "C is at the same location as A");
+    EXPECT_EQUAL(errorFrom("A (0, 0): B, B\nB (1, 1):"),       "City appears twice in outgoing list?");
+    EXPECT_EQUAL(errorFrom("A (0, 0): B, , B"),               "Blank name in list of outgoing cities?");
+    EXPECT_EQUAL(errorFrom("A (0, 0): B: C"),                 "Each data line should have exactly one colon on it.");
+}
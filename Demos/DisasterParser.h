@@ -6,6 +6,7 @@
 #include "hashset.h"
 #include "gtypes.h"
 #include <string>
+#include <string_view>
 #include <istream>
 
 /**
@@ -26,4 +27,73 @@ struct DisasterTest {
  */
 DisasterTest loadDisaster(std::istream& source);
 
+/**
+ * Loads the test case in the named file, following the same rules as loadDisaster.
+ * <p>
+ * The file is mapped into memory and scanned in place rather than read line by line,
+ * and each city name is copied out just once however many times it appears, so even
+ * very large generated networks load without holding several copies of the file.
+ *
+ * @param filename The file containing the test case.
+ * @return A test case from the file.
+ * @throws ErrorException If the file can't be read or is invalid.
+ */
+DisasterTest loadDisasterFile(const std::string& filename);
+
+/**
+ * Same as loadDisasterFile, but spreads the work across threads, for very large files.
+ * The file is split into chunks at line boundaries, and each thread reads its chunks
+ * into lists of its own, interning names in a table all threads share. Resolving cities
+ * listed twice, adding the reverse of each road, checking for missing cities and for
+ * cities in the same place, and sorting the cities are all done in parallel as well.
+ * The result, and the error for an invalid file, are the same as loadDisasterFile's.
+ *
+ * @param filename   The file containing the test case.
+ * @param numThreads How many threads to use, or 0 for one per hardware thread.
+ * @return A test case from the file.
+ * @throws ErrorException If the file can't be read or is invalid.
+ */
+DisasterTest loadDisasterFileInParallel(const std::string& filename, int numThreads = 0);
+
+/**
+ * Receives the contents of a .dst file as it's read, for passes over a network, such as
+ * counting degrees or pulling out one region, that don't need all of it in memory at
+ * once. Subclass it and hand it to parseDisaster or parseDisasterFile.
+ * <p>
+ * Each line is checked with the same rules loadDisaster uses, and a bad line raises the
+ * same error, after the calls for whatever came before the problem on that line. Checks
+ * that span lines aren't made: roads to cities that have no line of their own, cities
+ * at the same location, and cities with more than one line all pass through as they
+ * are. Roads are reported once, in the direction they're written.
+ * <p>
+ * The names passed to the callbacks only last until the callback returns; copy them to
+ * keep them.
+ */
+class DisasterParser {
+public:
+    virtual ~DisasterParser() = default;
+
+    /* Called for the city at the start of each line, in the order of the file. */
+    virtual void onCity(std::string_view name, double x, double y) = 0;
+
+    /* Called for each road on a city's line, in order, right after onCity for it. */
+    virtual void onRoad(std::string_view from, std::string_view to) = 0;
+};
+
+/**
+ * Reads a test case from a stream, one line at a time, passing what it finds to the
+ * parser. Memory use depends only on the length of the longest line.
+ *
+ * @throws ErrorException If a line is invalid.
+ */
+void parseDisaster(std::istream& source, DisasterParser& parser);
+
+/**
+ * Same as parseDisaster, but for the named file, which is mapped into memory rather
+ * than read.
+ *
+ * @throws ErrorException If the file can't be read or a line is invalid.
+ */
+void parseDisasterFile(const std::string& filename, DisasterParser& parser);
+
 #endif
@@ -2,7 +2,12 @@ WINDOW_TITLE("Recursion to the Rescue!")
 
 RUN_TESTS_MENU_OPTION()
 MENU_ORDER("ShiftSchedulingGUI.cpp",
-           "DisasterGUI.cpp")
+           "DisasterGUI.cpp",
+           "DisasterBenchmark.cpp",
+           "DisasterLoadBenchmark.cpp",
+           "DisasterGenerator.cpp",
+           "DisasterBinary.cpp",
+           "DisasterFuzz.cpp")
            
 TEST_ORDER("ShiftScheduling.cpp",
            "WinSumLoseSum.cpp",
@@ -0,0 +1,46 @@
+#include "DisasterAllocations.h"
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+#ifdef DISASTER_COUNT_ALLOCATIONS
+
+namespace {
+    thread_local long long allocations = 0;
+
+    void* countedAllocate(size_t bytes) {
+        allocations++;
+        if (void* result = malloc(bytes == 0? 1 : bytes)) return result;
+        throw bad_alloc();
+    }
+}
+
+/* Replacements for the global allocation functions. The standard library's nothrow
+ * forms go through these; over-aligned allocations aren't counted.
+ */
+void* operator new(size_t bytes)   { return countedAllocate(bytes); }
+void* operator new[](size_t bytes) { return countedAllocate(bytes); }
+void operator delete(void* memory) noexcept   { free(memory); }
+void operator delete[](void* memory) noexcept { free(memory); }
+void operator delete(void* memory, size_t) noexcept   { free(memory); }
+void operator delete[](void* memory, size_t) noexcept { free(memory); }
+
+bool DisasterAllocations::isCounting() {
+    return true;
+}
+
+long long DisasterAllocations::count() {
+    return allocations;
+}
+
+#else
+
+bool DisasterAllocations::isCounting() {
+    return false;
+}
+
+long long DisasterAllocations::count() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Counts heap allocations, so that tests and benchmarks can check that a solver doesn't
+ * allocate while it searches. For example:
+ *
+ *     long long before = DisasterAllocations::count();
+ *     search(...);
+ *     long long allocations = DisasterAllocations::count() - before;
+ *
+ * Allocations are only counted if DISASTER_COUNT_ALLOCATIONS is defined (see the .pro
+ * file), in which case the global operator new is replaced with one that keeps count.
+ * Otherwise, count() always returns zero and nothing about allocation changes.
+ */
+namespace DisasterAllocations {
+    /* Whether this build counts allocations. */
+    bool isCounting();
+
+    /* How many times the calling thread has allocated memory with operator new. Each
+     * thread has its own count, so work on other threads doesn't show up in it.
+     */
+    long long count();
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "error.h"
+
+/**
+ * A block of memory reserved once and then handed out piece by piece. Pieces are never
+ * returned individually; they all go away when the arena does. This lets a solver size
+ * all of its working memory from the network up front, so that nothing it does while
+ * searching touches the heap.
+ * <p>
+ * Only trivially destructible types can live in an arena, since nothing in it is ever
+ * destroyed.
+ */
+class DisasterArena {
+public:
+    /* Reserves the given number of bytes. */
+    explicit DisasterArena(std::size_t capacity)
+        : memory(new unsigned char[capacity]), capacity_(capacity) {}
+
+    /* Bytes needed to hold count objects of type T, including worst-case padding to get
+     * them aligned. Add these up to size an arena.
+     */
+    template <typename T> static std::size_t bytesFor(std::size_t count) {
+        return count * sizeof(T) + alignof(T) - 1;
+    }
+
+    /**
+     * Hands out uninitialized space for count objects of type T.
+     *
+     * @throws ErrorException If the arena doesn't have that much room left.
+     */
+    template <typename T> T* allocate(std::size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "Arena objects are never destroyed.");
+
+        std::size_t start = (used + alignof(T) - 1) / alignof(T) * alignof(T);
+        if (start > capacity_ || count > (capacity_ - start) / sizeof(T)) {
+            error("Arena is out of space.");
+        }
+        used = start + count * sizeof(T);
+        return reinterpret_cast<T*>(memory.get() + start);
+    }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t bytesUsed() const { return used; }
+
+private:
+    std::unique_ptr<unsigned char[]> memory;
+    std::size_t capacity_;
+    std::size_t used = 0;
+};
+
+/**
+ * A stack whose storage comes from an arena and whose capacity is fixed when it's made.
+ * Pushing past that capacity is a bug in whoever sized it.
+ */
+template <typename T> class ArenaStack {
+public:
+    ArenaStack(DisasterArena& arena, std::size_t capacity)
+        : items(arena.allocate<T>(capacity)), capacity(capacity) {}
+
+    void push_back(const T& item) {
+        if (count == capacity) error("Arena stack is full.");
+        items[count++] = item;
+    }
+
+    void pop_back()          { count--; }
+    void clear()             { count = 0; }
+    T& back()                { return items[count - 1]; }
+    std::size_t size() const { return count; }
+    bool empty() const       { return count == 0; }
+
+    const T* begin() const   { return items; }
+    const T* end()   const   { return items + count; }
+
+private:
+    T* items;
+    std::size_t capacity;
+    std::size_t count = 0;
+};
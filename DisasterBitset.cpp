@@ -0,0 +1,266 @@
+#include "DisasterSolvers.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+using namespace std;
+
+namespace {
+    /* How many nodes to visit between checks for cancellation. */
+    const long long kCancelCheckInterval = 4096;
+
+    /* A set of cities, one bit each, in a number of 64-bit words fixed at compile time.
+     * Every loop below runs over a constant number of words, so the compiler can unroll
+     * it and keep the words in registers.
+     */
+    template <int Words> using Bits = array<uint64_t, Words>;
+
+    template <int Words> bool isEmpty(const Bits<Words>& bits) {
+        uint64_t any = 0;
+        for (int i = 0; i < Words; i++) any |= bits[i];
+        return any == 0;
+    }
+
+    template <int Words> int countOf(const Bits<Words>& bits) {
+        int result = 0;
+        for (int i = 0; i < Words; i++) result += __builtin_popcountll(bits[i]);
+        return result;
+    }
+
+    /* Cities in both sets. */
+    template <int Words> Bits<Words> both(const Bits<Words>& lhs, const Bits<Words>& rhs) {
+        Bits<Words> result;
+        for (int i = 0; i < Words; i++) result[i] = lhs[i] & rhs[i];
+        return result;
+    }
+
+    /* lhs with everything in rhs taken out. */
+    template <int Words> Bits<Words> without(const Bits<Words>& lhs, const Bits<Words>& rhs) {
+        Bits<Words> result;
+        for (int i = 0; i < Words; i++) result[i] = lhs[i] & ~rhs[i];
+        return result;
+    }
+
+    /* Calls f on each city in the set, in increasing order. */
+    template <int Words, typename F> void forEach(const Bits<Words>& bits, F f) {
+        for (int i = 0; i < Words; i++) {
+            for (uint64_t word = bits[i]; word != 0; word &= word - 1) {
+                f(64 * i + __builtin_ctzll(word));
+            }
+        }
+    }
+
+    /* Search over bitsets of a given size. Each node picks the uncovered city with the
+     * fewest cities left that could cover it and tries each of those in turn, ruling
+     * each one out for the later branches once it's been tried. The sets passed down are
+     * small enough to copy, so backtracking needs no undo.
+     */
+    template <int Words> class BitsetSearch {
+    public:
+        BitsetSearch(const DisasterGraph& graph, int numCities, vector<int>& chosen,
+                     SearchStats* stats, const CancelFlag* cancel)
+            : chosen(chosen), stats(stats), cancel(cancel) {
+            int n = graph.numCities();
+            budget = min(numCities, n);
+
+            neighborhoods.resize(n);
+            everyone.fill(0);
+            for (int city = 0; city < n; city++) {
+                Bits<Words>& neighborhood = neighborhoods[city];
+                neighborhood.fill(0);
+                add(neighborhood, city);
+                for (int neighbor: graph.neighborsOf(city)) {
+                    add(neighborhood, neighbor);
+                }
+                add(everyone, city);
+                maxCover = max(maxCover, graph.degree(city) + 1);
+            }
+        }
+
+        bool run() {
+            chosen.clear();
+            chosen.reserve(budget);
+            return search(everyone, everyone, budget);
+        }
+
+    private:
+        vector<Bits<Words>> neighborhoods;  // Each city along with its neighbors
+        Bits<Words> everyone;
+        int budget;
+        int maxCover = 0;                   // Most cities any one city covers
+
+        vector<int>& chosen;
+        SearchStats* stats;
+        const CancelFlag* cancel;
+        long long steps = 0;
+        bool cancelled = false;
+
+        static void add(Bits<Words>& bits, int city) {
+            bits[city / 64] |= uint64_t(1) << (city % 64);
+        }
+
+        bool search(const Bits<Words>& uncovered, Bits<Words> available, int remaining) {
+            STATS_RECORD(stats, visitNode(budget - remaining));
+
+            if (cancel && ++steps % kCancelCheckInterval == 0 && cancel->load(memory_order_relaxed)) {
+                cancelled = true;
+            }
+            if (cancelled) return false;
+
+            if (isEmpty<Words>(uncovered)) return true;
+
+            int numUncovered = countOf<Words>(uncovered);
+            if (remaining == 0 || numUncovered > remaining * maxCover) {
+                STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+                return false;
+            }
+
+            /* Find the uncovered city with the fewest options. */
+            int target = -1, fewest = 0;
+            forEach<Words>(uncovered, [&](int city) {
+                if (target != -1 && fewest <= 1) return;
+
+                int options = countOf<Words>(both<Words>(neighborhoods[city], available));
+                if (target == -1 || options < fewest) {
+                    target = city;
+                    fewest = options;
+                }
+            });
+            if (fewest == 0) {
+                STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                return false;
+            }
+            STATS_RECORD(stats, branch(fewest));
+
+            bool found = false;
+            forEach<Words>(both<Words>(neighborhoods[target], available), [&](int city) {
+                if (found) return;
+
+                chosen.push_back(city);
+                if (search(without<Words>(uncovered, neighborhoods[city]), available, remaining - 1)) {
+                    found = true;
+                    return;
+                }
+                chosen.pop_back();
+
+                available[city / 64] &= ~(uint64_t(1) << (city % 64));
+            });
+            return found;
+        }
+    };
+
+    template <int Words> bool searchWith(const DisasterGraph& graph, int numCities,
+                                         vector<int>& chosen, SearchStats* stats,
+                                         const CancelFlag* cancel) {
+        BitsetSearch<Words> search(graph, numCities, chosen, stats, cancel);
+        return search.run();
+    }
+}
+
+bool bitsetSearch(const DisasterGraph& graph, int numCities,
+                  vector<int>& chosen, SearchStats* stats,
+                  const CancelFlag* cancel) {
+    int words = (graph.numCities() + 63) / 64;
+    if (words <= 1) return searchWith<1>(graph, numCities, chosen, stats, cancel);
+    if (words <= 2) return searchWith<2>(graph, numCities, chosen, stats, cancel);
+    if (words <= 4) return searchWith<4>(graph, numCities, chosen, stats, cancel);
+    if (words <= 8) return searchWith<8>(graph, numCities, chosen, stats, cancel);
+    return dancingLinksSearch(graph, numCities, chosen, stats, cancel);
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "Demos/DisasterGenerator.h"
+
+namespace {
+    /* A ring of the given size, which needs a third of its cities, rounded up. */
+    DisasterGraph ringOf(int numCities) {
+        Map<string, Set<string>> ring;
+        for (int i = 0; i < numCities; i++) {
+            string city = "City " + to_string(i);
+            string next = "City " + to_string((i + 1) % numCities);
+            ring[city] += next;
+            ring[next] += city;
+        }
+        return toGraph(ring);
+    }
+}
+
+STUDENT_TEST("Bitset search handles every word count.") {
+    /* Sizes on either side of each word boundary. */
+    for (int numCities: { 3, 63, 64, 65, 128, 129, 256, 257, 512 }) {
+        DisasterGraph ring = ringOf(numCities);
+        int needed = (numCities + 2) / 3;
+
+        vector<int> chosen;
+        EXPECT(!bitsetSearch(ring, needed - 1, chosen));
+        EXPECT(bitsetSearch(ring, needed, chosen));
+        EXPECT_EQUAL(int(chosen.size()), needed);
+
+        /* Everything is covered. */
+        vector<bool> covered(numCities);
+        for (int city: chosen) {
+            covered[city] = true;
+            for (int neighbor: ring.neighborsOf(city)) {
+                covered[neighbor] = true;
+            }
+        }
+        EXPECT(find(covered.begin(), covered.end(), false) == covered.end());
+    }
+}
+
+STUDENT_TEST("Bitset search agrees with the other solvers.") {
+    /* Chains of triangles, each joined to the next, of several sizes. Each triangle needs
+     * its own city. Showing that one fewer won't do takes a long search, so that's only
+     * checked for the smaller chains.
+     */
+    for (int numTriangles: { 1, 5, 21, 22, 42, 43, 85, 86, 170 }) {
+        Map<string, Set<string>> network;
+        auto addRoad = [&](const string& one, const string& two) {
+            network[one] += two;
+            network[two] += one;
+        };
+        for (int i = 0; i < numTriangles; i++) {
+            string prefix = "T" + to_string(i) + "-";
+            addRoad(prefix + "A", prefix + "B");
+            addRoad(prefix + "B", prefix + "C");
+            addRoad(prefix + "C", prefix + "A");
+            if (i > 0) addRoad(prefix + "A", "T" + to_string(i - 1) + "-C");
+        }
+
+        if (numTriangles <= 10) {
+            EXPECT_EQUAL(placeEmergencySupplies(network, numTriangles - 1, SolverMode::BITSET), Nothing);
+            EXPECT_EQUAL(placeEmergencySupplies(network, numTriangles - 1, SolverMode::DANCING_LINKS), Nothing);
+        }
+        auto plan = placeEmergencySupplies(network, numTriangles, SolverMode::BITSET);
+        EXPECT_NOT_EQUAL(plan, Nothing);
+        EXPECT_EQUAL(plan.value().size(), numTriangles);
+        EXPECT_NOT_EQUAL(placeEmergencySupplies(network, numTriangles, SolverMode::DANCING_LINKS), Nothing);
+    }
+
+    /* Random networks on both sides of the smallest bitset size, at every budget up to
+     * the fewest cities needed, where the answer changes from no to yes.
+     */
+    for (int numCities: { 10, 40, 63, 64, 65 }) {
+        for (int seed = 0; seed < 3; seed++) {
+            NetworkSpec spec;
+            spec.shape = NetworkShape::GEOMETRIC;
+            spec.numCities = numCities;
+            spec.averageDegree = 6;
+            spec.seed = seed;
+            auto network = generateDisaster(spec).network;
+
+            for (int budget = 0; ; budget++) {
+                auto expected = placeEmergencySupplies(network, budget, SolverMode::DANCING_LINKS);
+                auto plan     = placeEmergencySupplies(network, budget, SolverMode::BITSET);
+                EXPECT_EQUAL(plan != Nothing, expected != Nothing);
+                if (plan == Nothing) continue;
+
+                EXPECT(plan.value().size() <= budget);
+                for (const string& city: network) {
+                    EXPECT(plan.value().contains(city) || !(plan.value() * network[city]).isEmpty());
+                }
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,426 @@
+#include "DisasterCapacity.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    /* How many nodes to visit between checks for cancellation. */
+    const long long kCancelCheckInterval = 4096;
+
+    /* What's been decided about each city. */
+    enum State : char {
+        UNDECIDED,
+        CHOSEN,
+        EXCLUDED
+    };
+
+    class CapacitatedSearch {
+    public:
+        CapacitatedSearch(const DisasterGraph& graph, int numCities, int capacity,
+                          SearchStats* stats, const CancelFlag* cancel)
+            : graph(graph), budget(min(numCities, graph.numCities())), capacity(capacity),
+              stats(stats), cancel(cancel) {
+            int n = graph.numCities();
+            state.assign(n, UNDECIDED);
+            servedBy.assign(n, -1);
+            load.assign(n, 0);
+            numUnserved = n;
+            visited.assign(n, 0);
+            seen.assign(n, 0);
+
+            int maxDegree = 0;
+            for (int city = 0; city < n; city++) {
+                maxDegree = max(maxDegree, graph.degree(city));
+            }
+            maxServed = min(capacity, maxDegree + 1);
+        }
+
+        bool run(vector<int>& result) {
+            if (!search()) return false;
+            result = servedBy;
+            return true;
+        }
+
+    private:
+        const DisasterGraph& graph;
+        int budget;
+        int capacity;
+        int maxServed;          // Most cities one new stockpile can add to those served
+        SearchStats* stats;
+        const CancelFlag* cancel;
+
+        vector<State> state;
+        vector<int> chosen;     // Cities with stockpiles, in the order chosen
+        vector<int> excluded;   // Cities ruled out, in order
+
+        /* The matching: which stockpile serves each city (-1 for none), and how many cities
+         * each stockpile serves. Every change is logged as (city, stockpile it had).
+         */
+        vector<int> servedBy;
+        vector<int> load;
+        vector<pair<int, int>> trail;
+        int numUnserved;
+
+        /* Scratch space for searches through the matching. A city or stockpile has been
+         * looked at in the current search if its entry matches the stamp.
+         */
+        vector<int> visited;
+        vector<int> seen;
+        vector<int> reached;
+        int stamp = 0;
+
+        long long steps = 0;
+        bool cancelled = false;
+
+        void assign(int city, int stockpile) {
+            int previous = servedBy[city];
+            trail.push_back({ city, previous });
+            if (previous == -1) {
+                numUnserved--;
+            } else {
+                load[previous]--;
+            }
+            servedBy[city] = stockpile;
+            load[stockpile]++;
+        }
+
+        void undo(size_t mark) {
+            while (trail.size() > mark) {
+                int city = trail.back().first;
+                int previous = trail.back().second;
+                trail.pop_back();
+
+                load[servedBy[city]]--;
+                servedBy[city] = previous;
+                if (previous == -1) {
+                    numUnserved++;
+                } else {
+                    load[previous]++;
+                }
+            }
+        }
+
+        /* Given a stockpile with room for one more city, tries to serve an unserved city
+         * by moving a chain of served cities along: a neighbor moves to this stockpile,
+         * one of its old stockpile's neighbors moves there in its place, and so on, until
+         * some unserved city can take the last place freed up. Stockpiles already visited
+         * on this pass are skipped.
+         */
+        bool fill(int stockpile) {
+            visited[stockpile] = stamp;
+            for (int city: graph.neighborsOf(stockpile)) {
+                int from = servedBy[city];
+                if (from == -1) {
+                    assign(city, stockpile);
+                    return true;
+                }
+
+                /* Cities with stockpiles of their own always stay put. */
+                if (from == stockpile || from == city || visited[from] == stamp) continue;
+                if (fill(from)) {
+                    assign(city, stockpile);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /* Gives a city a stockpile, which serves the city itself, then serves as many
+         * more cities as possible.
+         * <p>
+         * The matching was as large as possible before, so any way to serve more cities
+         * now has to end in a place that just opened up: one at the new stockpile, or
+         * the one the city leaves behind if another stockpile was serving it. A search
+         * that fails can't succeed later in the same pass, since all it did was look, so
+         * the stamp only changes after a success.
+         */
+        void choose(int city) {
+            state[city] = CHOSEN;
+            chosen.push_back(city);
+            int previous = servedBy[city];
+            assign(city, city);
+
+            stamp++;
+            while (load[city] < capacity && fill(city)) {
+                stamp++;
+            }
+            if (previous != -1 && load[previous] < capacity && visited[previous] != stamp) {
+                fill(previous);
+            }
+        }
+
+        void unchoose(int city, size_t mark) {
+            undo(mark);
+            chosen.pop_back();
+            state[city] = UNDECIDED;
+        }
+
+        /* Cities that could get a stockpile to let the given unserved city be served:
+         * those next to a city reachable from it by moving cities between stockpiles.
+         */
+        vector<int> waysToServe(int city) {
+            stamp++;
+            reached.assign(1, city);
+            vector<int> result;
+            auto addOption = [&](int option) {
+                if (state[option] == UNDECIDED && visited[option] != stamp) {
+                    visited[option] = stamp;
+                    result.push_back(option);
+                }
+            };
+
+            /* Stockpiles and cities reached so far are marked in seen. */
+            seen[city] = stamp;
+            for (size_t next = 0; next < reached.size(); next++) {
+                int current = reached[next];
+                auto visit = [&](int stockpile) {
+                    addOption(stockpile);
+                    if (state[stockpile] != CHOSEN || seen[stockpile] == stamp) return;
+                    seen[stockpile] = stamp;
+
+                    auto reach = [&](int served) {
+                        if (served != stockpile && servedBy[served] == stockpile && seen[served] != stamp) {
+                            seen[served] = stamp;
+                            reached.push_back(served);
+                        }
+                    };
+                    for (int neighbor: graph.neighborsOf(stockpile)) {
+                        reach(neighbor);
+                    }
+                };
+                visit(current);
+                for (int neighbor: graph.neighborsOf(current)) {
+                    visit(neighbor);
+                }
+            }
+            return result;
+        }
+
+        bool search() {
+            STATS_RECORD(stats, visitNode(int(chosen.size())));
+
+            if (cancel && ++steps % kCancelCheckInterval == 0 && cancel->load(memory_order_relaxed)) {
+                cancelled = true;
+            }
+            if (cancelled) return false;
+
+            if (numUnserved == 0) return true;
+
+            /* Each new stockpile adds at most maxServed cities to those served. */
+            int remaining = budget - int(chosen.size());
+            if (remaining == 0 || numUnserved > remaining * maxServed) {
+                STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+                return false;
+            }
+
+            /* Branch on the unserved city with the fewest ways to serve it. */
+            vector<int> candidates;
+            bool first = true;
+            for (int city = 0; city < graph.numCities() && (first || candidates.size() > 1); city++) {
+                if (servedBy[city] != -1) continue;
+
+                vector<int> options = waysToServe(city);
+                if (first || options.size() < candidates.size()) {
+                    candidates = options;
+                    first = false;
+                }
+            }
+            if (candidates.empty()) {
+                STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                return false;
+            }
+            STATS_RECORD(stats, branch(int(candidates.size())));
+
+            /* Once a city has been tried, no plan in a later branch uses it. */
+            size_t excludedMark = excluded.size();
+            bool found = false;
+            for (int city: candidates) {
+                size_t mark = trail.size();
+                choose(city);
+                if (search()) {
+                    found = true;
+                    break;
+                }
+                unchoose(city, mark);
+
+                state[city] = EXCLUDED;
+                excluded.push_back(city);
+            }
+
+            while (excluded.size() > excludedMark) {
+                state[excluded.back()] = UNDECIDED;
+                excluded.pop_back();
+            }
+            return found;
+        }
+    };
+}
+
+bool capacitatedSearch(const DisasterGraph& graph, int numCities, int capacity,
+                       vector<int>& servedBy, SearchStats* stats,
+                       const CancelFlag* cancel) {
+    CapacitatedSearch search(graph, numCities, capacity, stats, cancel);
+    return search.run(servedBy);
+}
+
+Optional<Map<string, string>> placeCapacitatedSupplies(const Map<string, Set<string>>& roadNetwork,
+                                                       int numCities,
+                                                       int capacity,
+                                                       SearchStats* stats) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    if (capacity < 1) {
+        error("Capacity must be at least one.");
+    }
+    TRACE_SCOPE_VALUE("placeCapacitatedSupplies", "numCities", numCities);
+
+    DisasterGraph graph;
+    {
+        TRACE_SCOPE("preprocess");
+        STATS_RECORD(stats, preprocessing.start());
+        graph = toGraph(roadNetwork);
+        STATS_RECORD(stats, preprocessing.stop());
+    }
+
+    vector<int> servedBy;
+    bool found;
+    {
+        TRACE_SCOPE("search");
+        STATS_RECORD(stats, search.start());
+        found = capacitatedSearch(graph, numCities, capacity, servedBy, stats);
+        STATS_RECORD(stats, search.stop());
+    }
+    if (!found) return Nothing;
+
+    STATS_RECORD(stats, reconstruction.start());
+    Map<string, string> result;
+    for (int city = 0; city < graph.numCities(); city++) {
+        result[graph.names[city]] = graph.names[servedBy[city]];
+    }
+    STATS_RECORD(stats, reconstruction.stop());
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+namespace {
+    /* Whether an assignment of cities to stockpiles follows the rules. */
+    bool isValidAssignment(const Map<string, Set<string>>& network, int capacity,
+                           const Map<string, string>& servedBy) {
+        Map<string, int> load;
+        for (const string& city: network) {
+            if (!servedBy.containsKey(city)) return false;
+
+            string stockpile = servedBy[city];
+            if (servedBy[stockpile] != stockpile) return false;
+            if (stockpile != city && !network[city].contains(stockpile)) return false;
+            if (++load[stockpile] > capacity) return false;
+        }
+        return servedBy.size() == network.size();
+    }
+
+    /* Whether the cities other than the given stockpiles can each be given one of them,
+     * trying every way of handing them out.
+     */
+    bool canServe(const Map<string, Set<string>>& network, const Set<string>& stockpiles,
+                  const Vector<string>& cities, int index, Map<string, int>& spare) {
+        if (index == cities.size()) return true;
+
+        string city = cities[index];
+        if (stockpiles.contains(city)) return canServe(network, stockpiles, cities, index + 1, spare);
+        for (const string& stockpile: network[city] * stockpiles) {
+            if (spare[stockpile] == 0) continue;
+            spare[stockpile]--;
+            bool served = canServe(network, stockpiles, cities, index + 1, spare);
+            spare[stockpile]++;
+            if (served) return true;
+        }
+        return false;
+    }
+
+    /* Fewest stockpiles needed, by trying every combination. */
+    int bruteForceCapacitated(const Map<string, Set<string>>& network, int capacity) {
+        Vector<string> cities = network.keys();
+        int best = cities.size();
+        for (int mask = 0; mask < (1 << cities.size()); mask++) {
+            Set<string> stockpiles;
+            Map<string, int> spare;
+            for (int i = 0; i < cities.size(); i++) {
+                if (mask & (1 << i)) {
+                    stockpiles += cities[i];
+                    spare[cities[i]] = capacity - 1;
+                }
+            }
+            if (stockpiles.size() < best && canServe(network, stockpiles, cities, 0, spare)) {
+                best = stockpiles.size();
+            }
+        }
+        return best;
+    }
+}
+
+STUDENT_TEST("Capacity limits force extra stockpiles around a hub.") {
+    /* A hub with six cities around it. */
+    Map<string, Set<string>> star;
+    for (int i = 0; i < 6; i++) {
+        string city = "Spoke " + to_string(i);
+        star[city] += "Hub";
+        star["Hub"] += city;
+    }
+
+    /* Unlimited, the hub covers everything. */
+    EXPECT_NOT_EQUAL(placeCapacitatedSupplies(star, 1, 7), Nothing);
+    EXPECT_EQUAL(placeCapacitatedSupplies(star, 1, 6), Nothing);
+
+    /* The hub can serve itself and two others; the remaining four serve themselves. */
+    EXPECT_EQUAL(placeCapacitatedSupplies(star, 4, 3), Nothing);
+    auto plan = placeCapacitatedSupplies(star, 5, 3);
+    EXPECT_NOT_EQUAL(plan, Nothing);
+    EXPECT(isValidAssignment(star, 3, plan.value()));
+    EXPECT_EQUAL(plan.value()["Hub"], "Hub");
+
+    EXPECT_ERROR(placeCapacitatedSupplies(star, 1, 0));
+    EXPECT_ERROR(placeCapacitatedSupplies(star, -1, 1));
+    EXPECT_EQUAL(placeCapacitatedSupplies({}, 0, 1), Map<string, string>());
+}
+
+STUDENT_TEST("Capacitated plans match brute force on random networks.") {
+    mt19937_64 engine(314159);
+    for (int round = 0; round < 40; round++) {
+        int n = 1 + engine() % 9;
+        Map<string, Set<string>> network;
+        for (int i = 0; i < n; i++) {
+            network["City " + to_string(i)];
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                if (engine() % 3 == 0) {
+                    network["City " + to_string(i)] += "City " + to_string(j);
+                    network["City " + to_string(j)] += "City " + to_string(i);
+                }
+            }
+        }
+
+        for (int capacity = 1; capacity <= 4; capacity++) {
+            int fewest = bruteForceCapacitated(network, capacity);
+            if (fewest > 0) {
+                EXPECT_EQUAL(placeCapacitatedSupplies(network, fewest - 1, capacity), Nothing);
+            }
+            auto plan = placeCapacitatedSupplies(network, fewest, capacity);
+            EXPECT_NOT_EQUAL(plan, Nothing);
+            if (plan != Nothing) {
+                EXPECT(isValidAssignment(network, capacity, plan.value()));
+            }
+        }
+
+        /* Enough capacity for every neighborhood is the plain problem. */
+        int plain = 0;
+        while (placeEmergencySupplies(network, plain, SolverMode::ITERATIVE) == Nothing) plain++;
+        EXPECT_EQUAL(bruteForceCapacitated(network, n), plain);
+        EXPECT_NOT_EQUAL(placeCapacitatedSupplies(network, plain, n), Nothing);
+    }
+}
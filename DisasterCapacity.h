@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DisasterGraph.h"
+#include "DisasterSolvers.h"
+#include "DisasterStats.h"
+#include "map.h"
+#include "set.h"
+
+/**
+ * Given a road network, a number of cities that can have supplies, and how many cities
+ * each stockpile can serve, determines whether supplies can be placed so that every city
+ * is served by a stockpile in it or next to it without any stockpile serving more than
+ * its capacity. A city with a stockpile always serves itself, which counts toward its
+ * capacity.
+ * <p>
+ * With a capacity larger than any city's number of roads, this is the same question
+ * placeEmergencySupplies answers.
+ *
+ * @param roadNetwork The network, with bidirectional roads as in placeEmergencySupplies.
+ * @param numCities   How many cities can have supplies. Must not be negative.
+ * @param capacity    Most cities one stockpile can serve. Must be at least one.
+ * @param stats       If non-null, filled in with statistics about the search.
+ * @return The city serving each city, or Nothing if there's no way to do it. The cities
+ *         with supplies are exactly the ones serving themselves.
+ * @throws ErrorException If numCities is negative or capacity is less than one.
+ */
+Optional<Map<std::string, std::string>>
+placeCapacitatedSupplies(const Map<std::string, Set<std::string>>& roadNetwork,
+                         int numCities,
+                         int capacity,
+                         SearchStats* stats = nullptr);
+
+/**
+ * Engine for placeCapacitatedSupplies on the compact graph. On success, servedBy holds the
+ * city serving each city.
+ * <p>
+ * The search keeps a maximum matching of cities to the chosen stockpiles, with each
+ * stockpile taking up to capacity cities. Adding a stockpile only ever lets more cities
+ * be served, so the matching is extended with augmenting paths rather than rebuilt, and
+ * every change to it is logged so backtracking can unwind it. When some city can't be
+ * served, any plan that serves it must add a stockpile next to a city its augmenting
+ * path search reached, so the search branches on those, picking the unserved city that
+ * leaves the fewest.
+ */
+bool capacitatedSearch(const DisasterGraph& graph, int numCities, int capacity,
+                       std::vector<int>& servedBy, SearchStats* stats = nullptr,
+                       const CancelFlag* cancel = nullptr);
@@ -0,0 +1,253 @@
+#include "DisasterCenters.h"
+#include "DisasterCoverage.h"
+#include "DisasterGeometry.h"
+#include "DisasterKDTree.h"
+#include "DisasterSolvers.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    /* Most times to halve the range of radii when the cities are too many to solve
+     * exactly.
+     */
+    const int kBisectionSteps = 40;
+
+    /* Radii are widened by this fraction when building networks, so a pair exactly at
+     * the radius isn't lost to rounding.
+     */
+    const double kRadiusSlack = 1e-9;
+
+    /* Farthest any point is from the nearest of the chosen ones. */
+    double radiusOf(const vector<GPoint>& points, const vector<int>& chosen) {
+        vector<GPoint> stockpiles;
+        for (int city: chosen) {
+            stockpiles.push_back(points[city]);
+        }
+        KDTree tree(stockpiles);
+
+        double result = 0;
+        for (const GPoint& point: points) {
+            result = max(result, distanceBetween(point, stockpiles[tree.nearest(point)]));
+        }
+        return result;
+    }
+
+    /* Repeatedly adds whichever point is farthest from every one chosen so far. */
+    vector<int> farthestFirst(const vector<GPoint>& points, int numCities) {
+        vector<double> distance(points.size());
+        vector<int> result = { 0 };
+        for (size_t i = 0; i < points.size(); i++) {
+            distance[i] = distanceBetween(points[i], points[0]);
+        }
+
+        while (int(result.size()) < numCities) {
+            int farthest = max_element(distance.begin(), distance.end()) - distance.begin();
+            result.push_back(farthest);
+            for (size_t i = 0; i < points.size(); i++) {
+                distance[i] = min(distance[i], distanceBetween(points[i], points[farthest]));
+            }
+        }
+        return result;
+    }
+
+    /* The network joining every pair of points at most radius apart. */
+    DisasterGraph networkWithin(const KDTree& tree, const vector<GPoint>& points,
+                                const Vector<string>& names, double radius) {
+        DisasterGraph result;
+        result.names = names;
+        result.offsets.push_back(0);
+        for (int city = 0; city < int(points.size()); city++) {
+            vector<int> near = tree.withinRadius(points[city], radius * (1 + kRadiusSlack));
+            sort(near.begin(), near.end());
+            for (int other: near) {
+                if (other != city) result.neighbors.push_back(other);
+            }
+            result.offsets.push_back(int(result.neighbors.size()));
+        }
+        return result;
+    }
+}
+
+Optional<CenterPlan> placeSuppliesByDistance(const Map<string, GPoint>& cityLocations,
+                                             int numCities) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    TRACE_SCOPE_VALUE("placeSuppliesByDistance", "numCities", numCities);
+
+    Vector<string> names = cityLocations.keys();
+    vector<GPoint> points;
+    for (const string& city: names) {
+        points.push_back(cityLocations[city]);
+    }
+    int n = points.size();
+
+    CenterPlan result;
+    if (n == 0 || numCities >= n) {
+        for (const string& city: names) {
+            result.locations += city;
+        }
+        result.optimal = true;
+        return result;
+    }
+    if (numCities == 0) return Nothing;
+
+    vector<int> best = farthestFirst(points, numCities);
+    double bestRadius = radiusOf(points, best);
+
+    /* Whether numCities stockpiles can get every city within the given radius, keeping
+     * the plan if it beats the best so far. Only a yes is certain when solving greedily;
+     * a greedy no just means the greedy plan didn't manage it.
+     */
+    KDTree tree(points);
+    auto achievable = [&](double radius) {
+        TRACE_SCOPE("radius");
+        DisasterGraph network = networkWithin(tree, points, names, radius);
+
+        vector<int> chosen;
+        bool found = n <= kMaxExactCenterCities? bitsetSearch(network, numCities, chosen)
+                                               : greedyCoverage(network, numCities, chosen) == n;
+        if (found) {
+            double planRadius = radiusOf(points, chosen);
+            if (planRadius < bestRadius) {
+                best = chosen;
+                bestRadius = planRadius;
+            }
+        }
+        return found;
+    };
+
+    if (n <= kMaxExactCenterCities) {
+        /* The answer is one of the distances between cities no farther apart than the
+         * farthest-first radius.
+         */
+        vector<double> radii = { 0 };
+        for (int city = 0; city < n; city++) {
+            for (int other: tree.withinRadius(points[city], bestRadius * (1 + kRadiusSlack))) {
+                if (city < other) radii.push_back(distanceBetween(points[city], points[other]));
+            }
+        }
+        sort(radii.begin(), radii.end());
+        radii.erase(unique(radii.begin(), radii.end()), radii.end());
+
+        /* Invariant: radii[high] is achievable and everything below low isn't. */
+        int low = 0;
+        int high = radii.size() - 1;
+        while (low < high) {
+            int mid = low + (high - low) / 2;
+            if (achievable(radii[mid])) {
+                high = mid;
+            } else {
+                low = mid + 1;
+            }
+        }
+
+        /* The search may have narrowed in on the answer without ever solving for it. */
+        if (radii[high] < bestRadius) achievable(radii[high]);
+        result.optimal = true;
+    } else {
+        /* The farthest-first radius is at most twice the best. A greedy no is treated
+         * as a no, which can stop the search above the best radius; that's the price
+         * of not solving each step exactly.
+         */
+        double low = bestRadius / 2;
+        for (int step = 0; step < kBisectionSteps && bestRadius - low > kRadiusSlack * bestRadius; step++) {
+            double mid = (low + bestRadius) / 2;
+            if (!achievable(mid)) low = mid;
+        }
+    }
+
+    for (int city: best) {
+        result.locations += names[city];
+    }
+    result.radius = bestRadius;
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+namespace {
+    /* Smallest radius any plan of the given size achieves, by trying every combination. */
+    double bruteForceRadius(const vector<GPoint>& points, int numCities) {
+        int n = points.size();
+        double best = -1;
+        for (int mask = 0; mask < (1 << n); mask++) {
+            vector<int> chosen;
+            for (int i = 0; i < n; i++) {
+                if (mask & (1 << i)) chosen.push_back(i);
+            }
+            if (int(chosen.size()) != numCities) continue;
+
+            double radius = radiusOf(points, chosen);
+            if (best < 0 || radius < best) best = radius;
+        }
+        return best;
+    }
+
+    Map<string, GPoint> randomCities(mt19937_64& engine, int numCities, vector<GPoint>& points) {
+        Map<string, GPoint> result;
+        for (int i = 0; i < numCities; i++) {
+            result["City " + to_string(i)] = GPoint(engine() % 1000, engine() % 1000);
+        }
+        for (const string& city: result) {
+            points.push_back(result[city]);
+        }
+        return result;
+    }
+}
+
+STUDENT_TEST("Distance-based plans are optimal on small maps.") {
+    mt19937_64 engine(161803);
+    for (int round = 0; round < 30; round++) {
+        vector<GPoint> points;
+        auto cities = randomCities(engine, 1 + engine() % 10, points);
+
+        for (int k = 1; k <= 3 && k <= int(points.size()); k++) {
+            auto plan = placeSuppliesByDistance(cities, k);
+            EXPECT(plan != Nothing);
+            EXPECT(plan.value().optimal);
+            EXPECT_EQUAL(plan.value().locations.size(), k);
+            EXPECT(fabs(plan.value().radius - bruteForceRadius(points, k)) < 1e-9);
+
+            /* The radius reported is the one the plan has. */
+            vector<int> chosen;
+            for (int i = 0; i < cities.size(); i++) {
+                if (plan.value().locations.contains(cities.keys()[i])) chosen.push_back(i);
+            }
+            EXPECT(fabs(plan.value().radius - radiusOf(points, chosen)) < 1e-9);
+        }
+    }
+}
+
+STUDENT_TEST("Distance-based plans handle edge cases.") {
+    EXPECT_EQUAL(placeSuppliesByDistance({}, 0).value().locations, {});
+    EXPECT(placeSuppliesByDistance({ { "A", GPoint(0, 0) } }, 0) == Nothing);
+    EXPECT_ERROR(placeSuppliesByDistance({}, -1));
+
+    auto everywhere = placeSuppliesByDistance({ { "A", GPoint(0, 0) }, { "B", GPoint(3, 4) } }, 5);
+    EXPECT_EQUAL(everywhere.value().locations, { "A", "B" });
+    EXPECT_EQUAL(everywhere.value().radius, 0);
+
+    auto one = placeSuppliesByDistance({ { "A", GPoint(0, 0) }, { "B", GPoint(3, 4) } }, 1);
+    EXPECT_EQUAL(one.value().radius, 5);
+}
+
+STUDENT_TEST("Distance-based plans scale to thousands of cities.") {
+    mt19937_64 engine(271828);
+    vector<GPoint> points;
+    auto cities = randomCities(engine, 5000, points);
+
+    EXPECT_COMPLETES_IN(10.0, {
+        auto plan = placeSuppliesByDistance(cities, 25);
+        EXPECT(plan != Nothing);
+        EXPECT(!plan.value().optimal);
+        EXPECT_EQUAL(plan.value().locations.size(), 25);
+
+        /* No worse than where the search started. */
+        EXPECT(plan.value().radius <= radiusOf(points, farthestFirst(points, 25)));
+    });
+}
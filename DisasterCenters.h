@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include "DisasterPlanning.h"
+#include "gtypes.h"
+#include "map.h"
+#include "set.h"
+
+/* Largest number of cities for which placeSuppliesByDistance guarantees an optimal plan.
+ * Beyond this, it settles for a good one.
+ */
+const int kMaxExactCenterCities = 64;
+
+/**
+ * A plan that keeps every city close to a stockpile, as the crow flies.
+ */
+struct CenterPlan {
+    Set<std::string> locations;  // Cities to stockpile supplies in
+    double radius = 0;           // Farthest any city is from its nearest stockpile
+    bool optimal = false;        // Whether it's known that no plan has a smaller radius
+};
+
+/**
+ * Given where each city is and a number of cities that can have supplies, chooses where
+ * to put them so that the farthest any city is from its nearest stockpile, in a straight
+ * line, is as small as possible. (This is the p-center problem.) Roads play no part.
+ * <p>
+ * The best radius is always the distance between some pair of cities. For a given
+ * radius, whether that many stockpiles can get every city within it is a disaster
+ * planning question on the network joining every pair of cities that close together, so
+ * the search binary searches over radii, asking that question at each step. Those
+ * networks are built with a k-d tree.
+ * <p>
+ * It starts from the farthest-first plan (repeatedly add whichever city is farthest from
+ * every stockpile so far), whose radius is at most twice the best possible. With at most
+ * kMaxExactCenterCities cities, each step is solved exactly, over every pairwise
+ * distance, and the plan is optimal. With more, each step is solved greedily and the
+ * radius is bisected between half the farthest-first radius and the best found. That
+ * bisection is a heuristic: a radius the greedy plan can't reach is ruled out even if
+ * some other plan could reach it, so the plan found is no worse than farthest-first's
+ * but may not be the best.
+ *
+ * @param cityLocations Where each city is.
+ * @param numCities     How many cities can have supplies. Must not be negative.
+ * @return The plan, or Nothing if there are cities but no stockpiles allowed.
+ * @throws ErrorException If numCities is negative.
+ */
+Optional<CenterPlan> placeSuppliesByDistance(const Map<std::string, GPoint>& cityLocations,
+                                             int numCities);
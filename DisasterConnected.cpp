@@ -0,0 +1,572 @@
+#include "DisasterConnected.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    /* How many nodes to visit between checks for cancellation. */
+    const long long kCancelCheckInterval = 4096;
+
+    /* What's been decided about each city. */
+    enum State : char {
+        UNDECIDED,
+        CHOSEN,
+        EXCLUDED
+    };
+
+    /* Union-find over the chosen cities, tracking which pieces of the supplied network
+     * are joined up. There's no path compression, so every change is a single write
+     * that can be undone in reverse order; union by size keeps lookups logarithmic.
+     */
+    class Pieces {
+    public:
+        explicit Pieces(int numCities) : parent(numCities), size(numCities) {}
+
+        /* Adds a city as a piece of its own. */
+        void add(int city) {
+            parent[city] = city;
+            size[city] = 1;
+            numPieces++;
+            trail.push_back(~city);
+        }
+
+        /* Joins the pieces containing two cities. */
+        void join(int one, int two) {
+            one = find(one);
+            two = find(two);
+            if (one == two) return;
+
+            if (size[one] < size[two]) swap(one, two);
+            parent[two] = one;
+            size[one] += size[two];
+            numPieces--;
+            trail.push_back(two);
+        }
+
+        int find(int city) const {
+            while (parent[city] != city) city = parent[city];
+            return city;
+        }
+
+        int count() const {
+            return numPieces;
+        }
+
+        /* For use with undo: the point to unwind back to. */
+        size_t mark() const {
+            return trail.size();
+        }
+
+        /* Undoes every add and join since the given mark. */
+        void undo(size_t mark) {
+            while (trail.size() > mark) {
+                int entry = trail.back();
+                trail.pop_back();
+
+                if (entry < 0) {
+                    numPieces--;
+                } else {
+                    size[parent[entry]] -= size[entry];
+                    parent[entry] = entry;
+                    numPieces++;
+                }
+            }
+        }
+
+    private:
+        vector<int> parent;
+        vector<int> size;
+        vector<int> trail;  // ~city for an add, or the root that got attached for a join
+        int numPieces = 0;
+    };
+
+    class ConnectedSearch {
+    public:
+        ConnectedSearch(const DisasterGraph& graph, int numCities,
+                        SearchStats* stats, const CancelFlag* cancel)
+            : graph(graph), budget(min(numCities, graph.numCities())),
+              stats(stats), cancel(cancel), pieces(graph.numCities()) {
+            int n = graph.numCities();
+            state.assign(n, UNDECIDED);
+            coverCount.assign(n, 0);
+            options.resize(n);
+            for (int city = 0; city < n; city++) {
+                options[city] = graph.degree(city) + 1;
+                maxDegree = max(maxDegree, graph.degree(city));
+            }
+            numUncovered = n;
+            reached.assign(n, 0);
+            queue.reserve(n);
+            seen.assign(n, 0);
+            borderSize.assign(n, 0);
+        }
+
+        bool run(vector<int>& result) {
+            if (graph.numCities() == 0) {
+                result.clear();
+                return true;
+            }
+
+            /* The supplied cities can only join up if the whole network does. */
+            if (!allReachable()) return false;
+
+            if (!search()) return false;
+            result = chosen;
+            return true;
+        }
+
+    private:
+        const DisasterGraph& graph;
+        int budget;
+        SearchStats* stats;
+        const CancelFlag* cancel;
+
+        vector<State> state;
+        vector<int> coverCount;  // How many chosen cities cover each city
+        vector<int> options;     // How many cities that could cover each city aren't excluded
+        int numUncovered;
+        int maxDegree = 0;
+
+        vector<int> chosen;      // Chosen cities, in order
+        vector<int> excluded;    // Excluded cities, in order
+        Pieces pieces;
+
+        /* Scratch space for reachability checks and for finding borders. A city has been
+         * reached, or seen, if its entry matches the current stamp.
+         */
+        vector<int> reached;
+        vector<int> queue;
+        vector<int> seen;
+        int stamp = 0;
+
+        /* How many undecided cities border each piece, indexed by the piece's root. */
+        vector<int> borderSize;
+
+        long long steps = 0;
+        bool cancelled = false;
+
+        void choose(int city) {
+            state[city] = CHOSEN;
+            chosen.push_back(city);
+
+            auto cover = [&](int target) {
+                if (coverCount[target]++ == 0) numUncovered--;
+            };
+            cover(city);
+            pieces.add(city);
+            for (int neighbor: graph.neighborsOf(city)) {
+                cover(neighbor);
+                if (state[neighbor] == CHOSEN) pieces.join(city, neighbor);
+            }
+        }
+
+        void unchoose(int city, size_t piecesMark) {
+            pieces.undo(piecesMark);
+            for (int neighbor: graph.neighborsOf(city)) {
+                if (--coverCount[neighbor] == 0) numUncovered++;
+            }
+            if (--coverCount[city] == 0) numUncovered++;
+
+            chosen.pop_back();
+            state[city] = UNDECIDED;
+        }
+
+        /* Rules a city out, returning whether a plan might still be possible. */
+        bool exclude(int city) {
+            state[city] = EXCLUDED;
+            excluded.push_back(city);
+
+            bool possible = true;
+            auto lose = [&](int target) {
+                if (--options[target] == 0 && coverCount[target] == 0) possible = false;
+            };
+            lose(city);
+            for (int neighbor: graph.neighborsOf(city)) {
+                lose(neighbor);
+            }
+            return possible && canStillJoinUp();
+        }
+
+        void unexclude(int city) {
+            options[city]++;
+            for (int neighbor: graph.neighborsOf(city)) {
+                options[neighbor]++;
+            }
+            state[city] = UNDECIDED;
+            excluded.pop_back();
+        }
+
+        /* Marks every city that can be reached from the given one without passing through
+         * an excluded city, returning how many chosen cities were reached.
+         */
+        int reachFrom(int start) {
+            stamp++;
+            int numChosen = 0;
+            queue.clear();
+            queue.push_back(start);
+            reached[start] = stamp;
+            for (size_t next = 0; next < queue.size(); next++) {
+                int city = queue[next];
+                if (state[city] == CHOSEN) numChosen++;
+                for (int neighbor: graph.neighborsOf(city)) {
+                    if (state[neighbor] != EXCLUDED && reached[neighbor] != stamp) {
+                        reached[neighbor] = stamp;
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+            return numChosen;
+        }
+
+        bool allReachable() {
+            reachFrom(0);
+            return int(queue.size()) == graph.numCities();
+        }
+
+        /* Whether the chosen cities can still all be joined up through cities that aren't
+         * excluded, with every uncovered city next to one of those.
+         */
+        bool canStillJoinUp() {
+            if (chosen.empty()) return true;
+            if (reachFrom(chosen[0]) != int(chosen.size())) return false;
+
+            for (int city = 0; city < graph.numCities(); city++) {
+                if (coverCount[city] > 0 || reached[city] == stamp) continue;
+
+                bool reachable = false;
+                for (int neighbor: graph.neighborsOf(city)) {
+                    if (reached[neighbor] == stamp) {
+                        reachable = true;
+                        break;
+                    }
+                }
+                if (!reachable) return false;
+            }
+            return true;
+        }
+
+        /* Finds a smallest set of cities at least one of which must be chosen. */
+        vector<int> mustChooseFrom() {
+            vector<int> result;
+
+            /* The uncovered city with the fewest ways left to cover it. */
+            int target = -1;
+            for (int city = 0; city < graph.numCities(); city++) {
+                if (coverCount[city] == 0 && (target == -1 || options[city] < options[target])) {
+                    target = city;
+                }
+            }
+            if (target != -1) {
+                if (state[target] == UNDECIDED) result.push_back(target);
+                for (int neighbor: graph.neighborsOf(target)) {
+                    if (state[neighbor] == UNDECIDED) result.push_back(neighbor);
+                }
+            }
+
+            /* The piece of the supplied network with the fewest cities around it. Some
+             * city bordering each piece has to be chosen to join it to the others. A city
+             * bordering a piece in several places may be counted more than once here,
+             * which only affects which piece is picked.
+             */
+            if (pieces.count() > 1) {
+                for (int city: chosen) {
+                    borderSize[pieces.find(city)] = 0;
+                }
+                for (int city: chosen) {
+                    for (int neighbor: graph.neighborsOf(city)) {
+                        if (state[neighbor] == UNDECIDED) borderSize[pieces.find(city)]++;
+                    }
+                }
+
+                int smallest = -1;
+                for (int city: chosen) {
+                    int root = pieces.find(city);
+                    if (smallest == -1 || borderSize[root] < borderSize[smallest]) smallest = root;
+                }
+
+                if (target == -1 || borderSize[smallest] < int(result.size())) {
+                    result.clear();
+                    stamp++;
+                    for (int city: chosen) {
+                        if (pieces.find(city) != smallest) continue;
+                        for (int neighbor: graph.neighborsOf(city)) {
+                            if (state[neighbor] == UNDECIDED && seen[neighbor] != stamp) {
+                                seen[neighbor] = stamp;
+                                result.push_back(neighbor);
+                            }
+                        }
+                    }
+                }
+            }
+
+            /* Try cities covering the most new cities first, since they're likeliest to
+             * lead to a plan quickly.
+             */
+            vector<int> gains;
+            for (int city: result) {
+                int gain = (coverCount[city] == 0);
+                for (int neighbor: graph.neighborsOf(city)) {
+                    gain += (coverCount[neighbor] == 0);
+                }
+                gains.push_back(gain);
+            }
+            vector<int> order(result.size());
+            for (size_t i = 0; i < order.size(); i++) {
+                order[i] = i;
+            }
+            stable_sort(order.begin(), order.end(), [&](int lhs, int rhs) {
+                return gains[lhs] > gains[rhs];
+            });
+
+            vector<int> sorted;
+            for (int index: order) {
+                sorted.push_back(result[index]);
+            }
+            return sorted;
+        }
+
+        bool search() {
+            STATS_RECORD(stats, visitNode(int(chosen.size())));
+
+            if (cancel && ++steps % kCancelCheckInterval == 0 && cancel->load(memory_order_relaxed)) {
+                cancelled = true;
+            }
+            if (cancelled) return false;
+
+            if (numUncovered == 0 && pieces.count() == 1) return true;
+
+            /* Every city but the first newly covers at most maxDegree cities. */
+            int remaining = budget - int(chosen.size());
+            if (remaining == 0 ||
+                numUncovered > remaining * maxDegree + (chosen.empty()? 1 : 0)) {
+                STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+                return false;
+            }
+
+            vector<int> candidates = mustChooseFrom();
+            if (candidates.empty()) {
+                STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                return false;
+            }
+            STATS_RECORD(stats, branch(int(candidates.size())));
+
+            /* Once a city has been tried, no plan in a later branch uses it. */
+            size_t excludedMark = excluded.size();
+            bool found = false;
+            for (int city: candidates) {
+                size_t piecesMark = pieces.mark();
+                choose(city);
+                if (search()) {
+                    found = true;
+                    break;
+                }
+                unchoose(city, piecesMark);
+
+                if (!exclude(city)) {
+                    STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                    break;
+                }
+            }
+
+            while (excluded.size() > excludedMark) {
+                unexclude(excluded.back());
+            }
+            return found;
+        }
+    };
+}
+
+bool connectedSearch(const DisasterGraph& graph, int numCities,
+                     vector<int>& chosen, SearchStats* stats,
+                     const CancelFlag* cancel) {
+    ConnectedSearch search(graph, numCities, stats, cancel);
+    return search.run(chosen);
+}
+
+Optional<Set<string>> placeConnectedSupplies(const Map<string, Set<string>>& roadNetwork,
+                                             int numCities,
+                                             SearchStats* stats) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    TRACE_SCOPE_VALUE("placeConnectedSupplies", "numCities", numCities);
+
+    DisasterGraph graph;
+    {
+        TRACE_SCOPE("preprocess");
+        STATS_RECORD(stats, preprocessing.start());
+        graph = toGraph(roadNetwork);
+        STATS_RECORD(stats, preprocessing.stop());
+    }
+
+    vector<int> chosen;
+    bool found;
+    {
+        TRACE_SCOPE("search");
+        STATS_RECORD(stats, search.start());
+        found = connectedSearch(graph, numCities, chosen, stats);
+        STATS_RECORD(stats, search.stop());
+    }
+    if (!found) return Nothing;
+
+    STATS_RECORD(stats, reconstruction.start());
+    Optional<Set<string>> result = namesOf(graph, chosen);
+    STATS_RECORD(stats, reconstruction.stop());
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "Demos/DisasterParser.h"
+#include "filelib.h"
+#include "strlib.h"
+#include <chrono>
+#include <fstream>
+#include <random>
+
+namespace {
+    /* Whether a plan covers every city and its cities form one connected piece. */
+    bool isConnectedPlan(const Map<string, Set<string>>& network, const Set<string>& plan) {
+        for (const string& city: network) {
+            if (!plan.contains(city) && (plan * network[city]).isEmpty()) return false;
+        }
+        if (plan.isEmpty()) return network.isEmpty();
+
+        Set<string> reached = { plan.first() };
+        vector<string> frontier = { plan.first() };
+        while (!frontier.empty()) {
+            string city = frontier.back();
+            frontier.pop_back();
+            for (const string& neighbor: network[city] * plan) {
+                if (!reached.contains(neighbor)) {
+                    reached += neighbor;
+                    frontier.push_back(neighbor);
+                }
+            }
+        }
+        return reached == plan;
+    }
+
+    /* Fewest cities in a connected plan, by trying every combination, or -1 if there's
+     * no connected plan.
+     */
+    int bruteForceConnected(const Map<string, Set<string>>& network) {
+        Vector<string> cities = network.keys();
+        int best = -1;
+        for (int mask = 0; mask < (1 << cities.size()); mask++) {
+            Set<string> plan;
+            for (int i = 0; i < cities.size(); i++) {
+                if (mask & (1 << i)) plan += cities[i];
+            }
+            if ((best == -1 || plan.size() < best) && isConnectedPlan(network, plan)) {
+                best = plan.size();
+            }
+        }
+        return best;
+    }
+
+    /* Fewest cities a solver needs, counting up from zero, or -1 if it never succeeds. */
+    template <typename Solver> int fewestNeeded(const Map<string, Set<string>>& network,
+                                               Solver solver) {
+        for (int k = 0; k <= network.size(); k++) {
+            if (solver(network, k) != Nothing) return k;
+        }
+        return -1;
+    }
+}
+
+STUDENT_TEST("Connected plans on simple networks.") {
+    /* A path of n cities needs all but its endpoints. */
+    Map<string, Set<string>> path;
+    for (int i = 0; i < 8; i++) {
+        path["City " + to_string(i)];
+        if (i > 0) {
+            path["City " + to_string(i)]     += "City " + to_string(i - 1);
+            path["City " + to_string(i - 1)] += "City " + to_string(i);
+        }
+    }
+    EXPECT_EQUAL(placeConnectedSupplies(path, 5), Nothing);
+    auto plan = placeConnectedSupplies(path, 6);
+    EXPECT_NOT_EQUAL(plan, Nothing);
+    EXPECT(isConnectedPlan(path, plan.value()));
+
+    /* Two cities in the middle of a path would cover it, but aren't connected. */
+    EXPECT_NOT_EQUAL(placeEmergencySupplies(path, 3), Nothing);
+
+    /* Disconnected networks have no connected plan. */
+    EXPECT_EQUAL(placeConnectedSupplies({ { "A", {} }, { "B", {} } }, 2), Nothing);
+
+    /* Edge cases. */
+    EXPECT_EQUAL(placeConnectedSupplies({}, 0), Set<string>());
+    EXPECT_EQUAL(placeConnectedSupplies({ { "A", {} } }, 0), Nothing);
+    EXPECT_EQUAL(placeConnectedSupplies({ { "A", {} } }, 1), { "A" });
+    EXPECT_ERROR(placeConnectedSupplies({}, -1));
+}
+
+STUDENT_TEST("Connected plans match brute force on random networks.") {
+    mt19937_64 engine(1729);
+    for (int round = 0; round < 60; round++) {
+        int n = 1 + engine() % 11;
+        Map<string, Set<string>> network;
+        for (int i = 0; i < n; i++) {
+            network["City " + to_string(i)];
+        }
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                if (engine() % 3 == 0) {
+                    network["City " + to_string(i)] += "City " + to_string(j);
+                    network["City " + to_string(j)] += "City " + to_string(i);
+                }
+            }
+        }
+
+        int fewest = fewestNeeded(network, [](const Map<string, Set<string>>& network, int k) {
+            auto result = placeConnectedSupplies(network, k);
+            if (result != Nothing) EXPECT(isConnectedPlan(network, result.value()));
+            return result;
+        });
+        EXPECT_EQUAL(fewest, bruteForceConnected(network));
+    }
+}
+
+STUDENT_TEST("Connected plans for the bundled maps take about as long as plain ones.") {
+    /* Seconds it takes to find the smallest plan, best of a few tries to smooth out noise. */
+    auto timeFewest = [](const Map<string, Set<string>>& network, auto solver) {
+        double best = 0;
+        for (int trial = 0; trial < 3; trial++) {
+            auto start = chrono::steady_clock::now();
+            fewestNeeded(network, solver);
+            double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            if (trial == 0 || elapsed < best) best = elapsed;
+        }
+        return best;
+    };
+
+    for (const string& file: listDirectory("res/disaster-planning/")) {
+        if (!endsWith(file, ".dst") || startsWith(file, "VirtuallyImpossible")) continue;
+
+        ifstream input("res/disaster-planning/" + file);
+        auto network = loadDisaster(input).network;
+
+        int fewest = fewestNeeded(network, [](const Map<string, Set<string>>& network, int k) {
+            return placeConnectedSupplies(network, k);
+        });
+        if (fewest != -1) {
+            EXPECT(isConnectedPlan(network, placeConnectedSupplies(network, fewest).value()));
+        }
+
+        /* Compare against dancing links, which like the connected search branches on the
+         * smallest set of cities one of which has to be chosen. Connected plans are bigger
+         * and need more checks, so allow a generous factor, plus a little slack for maps
+         * solved too fast to time well.
+         */
+        double connected = timeFewest(network, [](const Map<string, Set<string>>& network, int k) {
+            return placeConnectedSupplies(network, k);
+        });
+        double plain = timeFewest(network, [](const Map<string, Set<string>>& network, int k) {
+            return placeEmergencySupplies(network, k, SolverMode::DANCING_LINKS);
+        });
+        EXPECT(connected <= 20 * plain + 0.01);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DisasterGraph.h"
+#include "DisasterSolvers.h"
+#include "DisasterStats.h"
+#include "map.h"
+#include "set.h"
+
+/**
+ * Given a road network and a number of cities that can have supplies, determines
+ * whether supplies can be placed so that every city is covered and the cities with
+ * supplies form a connected network of their own, so that each of them can be resupplied
+ * from any other without leaving the supplied cities. (This is a connected dominating
+ * set.)
+ * <p>
+ * A network made of several disconnected pieces has no such plan, other than the empty
+ * plan for the empty network.
+ *
+ * @param roadNetwork The network, with bidirectional roads as in placeEmergencySupplies.
+ * @param numCities   How many cities can have supplies. Must not be negative.
+ * @param stats       If non-null, filled in with statistics about the search.
+ * @return A plan meeting those rules, or Nothing if there isn't one.
+ * @throws ErrorException If numCities is negative.
+ */
+Optional<Set<std::string>>
+placeConnectedSupplies(const Map<std::string, Set<std::string>>& roadNetwork,
+                       int numCities,
+                       SearchStats* stats = nullptr);
+
+/**
+ * Engine for placeConnectedSupplies, on the compact graph, with the same conventions as
+ * the other engines in DisasterSolvers.h.
+ * <p>
+ * Each node of the search finds a set of cities at least one of which must be added:
+ * either the neighborhood of an uncovered city, or the cities bordering a piece of the
+ * supplied network that isn't yet joined to the rest. It branches on whichever set is
+ * smallest, ruling out each city once it's been tried. The pieces of the supplied
+ * network are tracked with a union-find structure that's unwound on backtracking. A
+ * branch is abandoned once the cities still available can't join up the pieces, or
+ * can't cover what's left. It's also abandoned when the budget is too small for what's
+ * left to cover: in a spanning tree of the supplied cities, every city but the first
+ * has a parent that's supplied, so it newly covers at most as many cities as it has
+ * roads.
+ */
+bool connectedSearch(const DisasterGraph& graph, int numCities,
+                     std::vector<int>& chosen, SearchStats* stats = nullptr,
+                     const CancelFlag* cancel = nullptr);
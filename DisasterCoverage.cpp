@@ -0,0 +1,361 @@
+#include "DisasterCoverage.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+using namespace std;
+
+namespace {
+    /* Cap on the work the exact search does, counted in neighborhood entries scanned.
+     * This keeps it to a few tens of milliseconds.
+     */
+    const long long kExactWorkLimit = 20000000;
+
+    /* How many cities in a city's neighborhood (including itself) aren't covered yet. */
+    int gainOf(const DisasterGraph& graph, const vector<int>& coverCount, int city) {
+        int result = (coverCount[city] == 0);
+        for (int neighbor: graph.neighborsOf(city)) {
+            result += (coverCount[neighbor] == 0);
+        }
+        return result;
+    }
+
+    /* Adjusts coverage counts for a city's neighborhood, returning the change in the
+     * number of covered cities.
+     */
+    int cover(const DisasterGraph& graph, vector<int>& coverCount, int city, int delta) {
+        int change = 0;
+        auto adjust = [&](int target) {
+            if (delta > 0 && coverCount[target] == 0) change++;
+            coverCount[target] += delta;
+            if (delta < 0 && coverCount[target] == 0) change--;
+        };
+
+        adjust(city);
+        for (int neighbor: graph.neighborsOf(city)) {
+            adjust(neighbor);
+        }
+        return change;
+    }
+
+    /* Branch and bound over which cities to choose. Cities are considered in order of
+     * decreasing neighborhood size, and each node of the search picks the next city to
+     * add from those after the last one added. A branch is abandoned when even the
+     * largest gains still available couldn't beat the best plan found so far, which is
+     * a valid bound because a city's gain never grows as others are chosen.
+     */
+    struct BranchAndBound {
+        const DisasterGraph& graph;
+        SearchStats* stats;
+
+        vector<int> candidates;  // Cities in the order they're considered
+        vector<int> coverCount;  // How many chosen cities cover each city
+        vector<int> current;     // Cities chosen so far
+        int covered = 0;
+
+        vector<int> best;
+        int bestCovered;
+
+        long long work = 0;
+        bool aborted = false;
+
+        BranchAndBound(const DisasterGraph& graph, const vector<int>& incumbent,
+                       int incumbentCovered, SearchStats* stats)
+            : graph(graph), stats(stats), best(incumbent), bestCovered(incumbentCovered) {
+            int n = graph.numCities();
+            coverCount.assign(n, 0);
+            for (int city = 0; city < n; city++) {
+                candidates.push_back(city);
+            }
+            stable_sort(candidates.begin(), candidates.end(), [&](int lhs, int rhs) {
+                return graph.degree(lhs) > graph.degree(rhs);
+            });
+        }
+
+        void search(int start, int remaining) {
+            STATS_RECORD(stats, visitNode(int(current.size())));
+
+            if (covered > bestCovered) {
+                best = current;
+                bestCovered = covered;
+            }
+            if (remaining == 0 || bestCovered == graph.numCities()) return;
+
+            /* Current gain of each remaining candidate. */
+            int numLeft = int(candidates.size()) - start;
+            vector<int> gains(numLeft);
+            for (int i = 0; i < numLeft; i++) {
+                gains[i] = gainOf(graph, coverCount, candidates[start + i]);
+                work += graph.degree(candidates[start + i]) + 1;
+            }
+            if (work > kExactWorkLimit) {
+                aborted = true;
+                return;
+            }
+
+            /* bounds[i] is the sum of the largest `remaining` gains from candidate i on. */
+            vector<int> bounds(numLeft + 1, 0);
+            priority_queue<int, vector<int>, greater<int>> largest;
+            int sum = 0;
+            for (int i = numLeft - 1; i >= 0; i--) {
+                largest.push(gains[i]);
+                sum += gains[i];
+                if (int(largest.size()) > remaining) {
+                    sum -= largest.top();
+                    largest.pop();
+                }
+                bounds[i] = sum;
+            }
+
+            int options = 0;
+            for (int i = 0; i < numLeft && !aborted; i++) {
+                /* Bounds only shrink from here on, so nothing later can help either. */
+                if (covered + bounds[i] <= bestCovered) {
+                    STATS_RECORD(stats, prune(PruneReason::NO_IMPROVEMENT));
+                    break;
+                }
+                if (gains[i] == 0) continue;
+
+                int city = candidates[start + i];
+                current.push_back(city);
+                covered += cover(graph, coverCount, city, +1);
+
+                search(start + i + 1, remaining - 1);
+
+                covered += cover(graph, coverCount, city, -1);
+                current.pop_back();
+                options++;
+            }
+            STATS_RECORD(stats, branch(options));
+        }
+    };
+}
+
+int greedyCoverage(const DisasterGraph& graph, int numCities, vector<int>& chosen) {
+    chosen.clear();
+    vector<int> coverCount(graph.numCities(), 0);
+
+    /* Entries are (gain, -city), so ties go to the lowest-numbered city. A stored gain
+     * is never less than the city's true gain, so if the city at the top still has the
+     * gain it was stored with, no other city can beat it.
+     */
+    priority_queue<pair<int, int>> queue;
+    for (int city = 0; city < graph.numCities(); city++) {
+        queue.push({ graph.degree(city) + 1, -city });
+    }
+
+    int covered = 0;
+    while (int(chosen.size()) < numCities && !queue.empty()) {
+        int stored = queue.top().first;
+        int city = -queue.top().second;
+        queue.pop();
+
+        int gain = gainOf(graph, coverCount, city);
+        if (gain == 0) continue;  // Never useful again.
+        if (gain < stored) {
+            queue.push({ gain, -city });
+            continue;
+        }
+
+        chosen.push_back(city);
+        covered += cover(graph, coverCount, city, +1);
+    }
+    return covered;
+}
+
+bool exactCoverage(const DisasterGraph& graph, int numCities,
+                   vector<int>& chosen, int& covered,
+                   SearchStats* stats) {
+    BranchAndBound search(graph, chosen, covered, stats);
+    search.search(0, numCities);
+
+    chosen  = search.best;
+    covered = search.bestCovered;
+    return !search.aborted;
+}
+
+CoveragePlan maximizeCoverage(const Map<string, Set<string>>& roadNetwork,
+                              int numCities,
+                              int exactBudget,
+                              SearchStats* stats) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    TRACE_SCOPE_VALUE("maximizeCoverage", "numCities", numCities);
+
+    DisasterGraph graph;
+    {
+        TRACE_SCOPE("preprocess");
+        STATS_RECORD(stats, preprocessing.start());
+        graph = toGraph(roadNetwork);
+        STATS_RECORD(stats, preprocessing.stop());
+    }
+
+    vector<int> chosen;
+    int covered;
+    bool optimal;
+    {
+        TRACE_SCOPE("search");
+        STATS_RECORD(stats, search.start());
+        covered = greedyCoverage(graph, numCities, chosen);
+
+        /* Covering everything, or choosing nothing, can't be beaten. */
+        optimal = covered == graph.numCities() || numCities == 0;
+        if (!optimal && numCities <= exactBudget) {
+            TRACE_SCOPE("exact");
+            optimal = exactCoverage(graph, numCities, chosen, covered, stats);
+        }
+        STATS_RECORD(stats, search.stop());
+    }
+
+    STATS_RECORD(stats, reconstruction.start());
+    CoveragePlan result;
+    result.locations     = namesOf(graph, chosen);
+    result.citiesCovered = covered;
+    result.optimal       = optimal;
+    STATS_RECORD(stats, reconstruction.stop());
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+namespace {
+    /* Builds a network from a list of roads, adding each in both directions. */
+    Map<string, Set<string>> networkFrom(const Vector<string>& cities,
+                                         const Vector<pair<string, string>>& roads) {
+        Map<string, Set<string>> result;
+        for (const string& city: cities) {
+            result[city] = {};
+        }
+        for (const auto& road: roads) {
+            result[road.first]  += road.second;
+            result[road.second] += road.first;
+        }
+        return result;
+    }
+
+    /* Most cities any numCities of them can cover, by trying every combination. */
+    int bruteForceCoverage(const Map<string, Set<string>>& network, int numCities) {
+        Vector<string> cities = network.keys();
+        int best = 0;
+        for (int mask = 0; mask < (1 << cities.size()); mask++) {
+            Set<string> chosen;
+            for (int i = 0; i < cities.size(); i++) {
+                if (mask & (1 << i)) chosen += cities[i];
+            }
+            if (chosen.size() > numCities) continue;
+
+            int covered = 0;
+            for (const string& city: network) {
+                if (chosen.contains(city) || !(chosen * network[city]).isEmpty()) covered++;
+            }
+            best = max(best, covered);
+        }
+        return best;
+    }
+
+    int coverageOf(const Map<string, Set<string>>& network, const Set<string>& chosen) {
+        int covered = 0;
+        for (const string& city: network) {
+            if (chosen.contains(city) || !(chosen * network[city]).isEmpty()) covered++;
+        }
+        return covered;
+    }
+}
+
+STUDENT_TEST("Maximum coverage covers everything when the budget allows.") {
+    auto path = networkFrom({ "A", "B", "C", "D", "E", "F" },
+                            { { "A", "B" }, { "B", "C" }, { "C", "D" }, { "D", "E" }, { "E", "F" } });
+
+    CoveragePlan plan = maximizeCoverage(path, 2);
+    EXPECT_EQUAL(plan.citiesCovered, 6);
+    EXPECT(plan.optimal);
+
+    plan = maximizeCoverage(path, 1);
+    EXPECT_EQUAL(plan.citiesCovered, 3);
+    EXPECT_EQUAL(plan.locations.size(), 1);
+    EXPECT(plan.optimal);
+
+    plan = maximizeCoverage(path, 0);
+    EXPECT_EQUAL(plan.citiesCovered, 0);
+    EXPECT(plan.optimal);
+
+    EXPECT_ERROR(maximizeCoverage(path, -1));
+}
+
+STUDENT_TEST("Exact refinement improves on a greedy plan.") {
+    /* C covers the most cities, but two stars centered on A and B together cover more
+     * than C and anything else.
+     */
+    auto network = networkFrom({ "A", "A1", "A2", "A3", "A4", "B", "B1", "B2", "B3", "B4", "C" }, {
+        { "A", "A1" }, { "A", "A2" }, { "A", "A3" }, { "A", "A4" },
+        { "B", "B1" }, { "B", "B2" }, { "B", "B3" }, { "B", "B4" },
+        { "C", "A1" }, { "C", "A2" }, { "C", "A3" }, { "C", "B1" }, { "C", "B2" }, { "C", "B3" },
+    });
+
+    CoveragePlan greedy = maximizeCoverage(network, 2, 0);
+    EXPECT_EQUAL(greedy.citiesCovered, 9);
+    EXPECT(!greedy.optimal);
+    EXPECT_EQUAL(coverageOf(network, greedy.locations), 9);
+
+    CoveragePlan exact = maximizeCoverage(network, 2);
+    EXPECT_EQUAL(exact.citiesCovered, 10);
+    EXPECT_EQUAL(exact.locations, { "A", "B" });
+    EXPECT(exact.optimal);
+}
+
+STUDENT_TEST("Maximum coverage matches brute force on random networks.") {
+    mt19937_64 engine(137);
+    for (int round = 0; round < 40; round++) {
+        int n = 1 + engine() % 12;
+        Vector<string> cities;
+        for (int i = 0; i < n; i++) {
+            cities += "City " + to_string(i);
+        }
+        Vector<pair<string, string>> roads;
+        for (int i = 0; i < n; i++) {
+            for (int j = i + 1; j < n; j++) {
+                if (engine() % 4 == 0) roads += make_pair(cities[i], cities[j]);
+            }
+        }
+        auto network = networkFrom(cities, roads);
+
+        for (int k = 0; k <= 4; k++) {
+            int best = bruteForceCoverage(network, k);
+            CoveragePlan greedy = maximizeCoverage(network, k, 0);
+            CoveragePlan exact  = maximizeCoverage(network, k);
+
+            EXPECT(greedy.locations.size() <= k);
+            EXPECT_EQUAL(coverageOf(network, greedy.locations), greedy.citiesCovered);
+            EXPECT(greedy.citiesCovered >= (1 - 1 / exp(1.0)) * best);
+
+            EXPECT(exact.optimal);
+            EXPECT_EQUAL(exact.citiesCovered, best);
+            EXPECT_EQUAL(coverageOf(network, exact.locations), best);
+        }
+    }
+}
+
+STUDENT_TEST("Greedy coverage is fast on large networks.") {
+    /* A long ladder: two paths joined rung by rung. */
+    const int kLength = 50000;
+    Map<string, Set<string>> ladder;
+    for (int i = 0; i < kLength; i++) {
+        for (string side: { "L", "R" }) {
+            string name = side + to_string(i);
+            ladder[name] += (side == "L"? "R" : "L") + to_string(i);
+            if (i > 0)           ladder[name] += side + to_string(i - 1);
+            if (i + 1 < kLength) ladder[name] += side + to_string(i + 1);
+        }
+    }
+
+    CoveragePlan plan;
+    EXPECT_COMPLETES_IN(2.0,
+        plan = maximizeCoverage(ladder, 1000);
+    );
+    EXPECT_EQUAL(plan.locations.size(), 1000);
+    EXPECT_EQUAL(plan.citiesCovered, 4000);
+}
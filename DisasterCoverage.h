@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DisasterGraph.h"
+#include "DisasterStats.h"
+#include "map.h"
+#include "set.h"
+
+/* Largest budget for which maximizeCoverage tries, by default, to improve on the greedy
+ * plan with an exact search.
+ */
+const int kMaxExactCoverageBudget = 6;
+
+/**
+ * A best-effort plan for a budget that may be too small to cover every city.
+ */
+struct CoveragePlan {
+    Set<std::string> locations;  // Cities to stockpile supplies in
+    int citiesCovered = 0;       // How many cities those supplies cover
+    bool optimal = false;        // Whether it's known that no plan covers more
+};
+
+/**
+ * Given a road network and a number of cities that can have supplies, chooses where to
+ * put supplies so as to cover as many cities as possible.
+ * <p>
+ * The plan starts out as the greedy one, which repeatedly picks whichever city covers
+ * the most cities not already covered. That's guaranteed to cover at least (1 - 1/e),
+ * about 63%, as many cities as the best plan, and takes milliseconds even on large
+ * networks. For budgets of at most exactBudget, an exact branch-and-bound search then
+ * tries to improve on it; that search gives up after a bounded amount of work, in which
+ * case the greedy plan (or the best found so far) is returned.
+ *
+ * @param roadNetwork The network, with bidirectional roads as in placeEmergencySupplies.
+ * @param numCities   How many cities can have supplies. Must not be negative.
+ * @param exactBudget Largest budget for which to attempt the exact search. Pass 0 to
+ *                    skip it.
+ * @param stats       If non-null, filled in with statistics about the exact search.
+ * @return The plan found.
+ */
+CoveragePlan maximizeCoverage(const Map<std::string, Set<std::string>>& roadNetwork,
+                              int numCities,
+                              int exactBudget = kMaxExactCoverageBudget,
+                              SearchStats* stats = nullptr);
+
+/**
+ * Lazy greedy maximum coverage on the compact graph. Gains only ever shrink as more
+ * cities are chosen, so each city's gain is kept in a priority queue and only
+ * recomputed when it reaches the top, rather than rescanning every city at each step.
+ *
+ * @return How many cities the chosen ones cover.
+ */
+int greedyCoverage(const DisasterGraph& graph, int numCities, std::vector<int>& chosen);
+
+/**
+ * Exact maximum coverage on the compact graph by branch and bound, starting from a
+ * known plan covering `covered` cities.
+ *
+ * @param chosen  On entry, a plan with at most numCities cities. On exit, the best plan
+ *                found, which is at least as good.
+ * @param covered How many cities the plan passed in covers; updated to match chosen.
+ * @return Whether the search ran to completion, proving chosen optimal.
+ */
+bool exactCoverage(const DisasterGraph& graph, int numCities,
+                   std::vector<int>& chosen, int& covered,
+                   SearchStats* stats = nullptr);
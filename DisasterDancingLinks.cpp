@@ -0,0 +1,393 @@
+#include "DisasterSolvers.h"
+#include "DisasterArena.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    /* How many nodes to visit between checks for cancellation. */
+    const long long kCancelCheckInterval = 4096;
+
+    /* Dancing links for set cover. There's a row for each city that could get supplies
+     * and a column for each city that needs to be covered, with a node wherever the
+     * row's city covers the column's city. Every node sits in two circular doubly-linked
+     * lists, one across its row and one down its column, and each column has a header
+     * node. The headers of columns not yet covered are linked together in a list of
+     * their own, starting at the root.
+     *
+     * Taking a node out of a list leaves its own links alone, so putting it back is just
+     * two writes, provided things are put back in the reverse of the order they were
+     * taken out. Links are indices into arrays rather than pointers.
+     */
+    class DancingLinks {
+    public:
+        /* Builds the links for the given graph, for a search using at most numCities
+         * cities, taking all memory from the arena.
+         */
+        DancingLinks(const DisasterGraph& graph, int numCities, DisasterArena& arena)
+            : budget(numCities),
+              numColumns(graph.numCities()),
+              numNodes(nodesFor(graph)),
+              left(arena.allocate<int>(numNodes)),
+              right(arena.allocate<int>(numNodes)),
+              up(arena.allocate<int>(numNodes)),
+              down(arena.allocate<int>(numNodes)),
+              column(arena.allocate<int>(numNodes)),
+              rowOf(arena.allocate<int>(numNodes)),
+              size(arena.allocate<int>(graph.numCities() + 1)),
+              coveredColumns(arena, graph.numCities()),
+              excludedRows(arena, graph.numCities()),
+              frames(arena, maxDepthFor(graph, numCities)) {
+            int n = numColumns;
+
+            /* Node 0 is the root, nodes 1 .. n are column headers. */
+            for (int header = 0; header <= n; header++) {
+                left[header]  = header == 0? n : header - 1;
+                right[header] = header == n? 0 : header + 1;
+                up[header] = down[header] = column[header] = header;
+                rowOf[header] = -1;
+                size[header]  = 0;
+            }
+
+            int next = n + 1;
+            for (int city = 0; city < n; city++) {
+                int first = next;
+                auto addNode = [&](int covered) {
+                    int node = next++;
+                    int header = covered + 1;
+
+                    /* Append to the bottom of the column. */
+                    column[node] = header;
+                    rowOf[node]  = city;
+                    up[node]     = up[header];
+                    down[node]   = header;
+                    down[up[header]] = node;
+                    up[header]   = node;
+                    size[header]++;
+
+                    /* Append to the end of the row. */
+                    left[node]  = node == first? node : left[first];
+                    right[node] = first;
+                    right[left[node]] = node;
+                    left[first] = node;
+                };
+
+                addNode(city);
+                for (int neighbor: graph.neighborsOf(city)) {
+                    addNode(neighbor);
+                }
+            }
+        }
+
+        /* How big an arena the links and search need. */
+        static size_t arenaBytesFor(const DisasterGraph& graph, int numCities) {
+            return 6 * DisasterArena::bytesFor<int>(nodesFor(graph))
+                 + DisasterArena::bytesFor<int>(graph.numCities() + 1)
+                 + 2 * DisasterArena::bytesFor<int>(graph.numCities())
+                 + DisasterArena::bytesFor<Frame>(maxDepthFor(graph, numCities));
+        }
+
+        bool search(vector<int>& chosen, SearchStats* stats, const CancelFlag* cancel);
+
+        /* Exposed for testing: the complete link structure. */
+        vector<int> links() const {
+            vector<int> result;
+            for (const int* list: { left, right, up, down }) {
+                result.insert(result.end(), list, list + numNodes);
+            }
+            result.insert(result.end(), size, size + numColumns + 1);
+            return result;
+        }
+
+    private:
+        /* One level of the search: which column we're covering, and which of its rows
+         * we're currently trying.
+         */
+        struct Frame {
+            int header;
+            int node;
+            size_t coveredMark;   // coveredColumns.size() before trying the current row
+            size_t excludedMark;  // excludedRows.size() when the frame began
+        };
+
+        int budget;
+        int numColumns;
+        int numNodes;
+        int* left;
+        int* right;
+        int* up;
+        int* down;
+        int* column;  // Header of each node's column
+        int* rowOf;   // City whose row each node is in
+        int* size;    // Number of rows still in each column
+
+        /* What's been taken out, in order, so it can be put back. Each column is covered
+         * at most once at a time, and so is each row excluded, since an excluded row is
+         * no longer in any column the search could pick.
+         */
+        ArenaStack<int> coveredColumns;
+        ArenaStack<int> excludedRows;
+
+        /* The search's decisions. Each frame chooses one city. */
+        ArenaStack<Frame> frames;
+
+        static int nodesFor(const DisasterGraph& graph) {
+            return 2 * graph.numCities() + 1 + int(graph.neighbors.size());
+        }
+
+        static size_t maxDepthFor(const DisasterGraph& graph, int numCities) {
+            return min(numCities, graph.numCities()) + 1;
+        }
+
+        /* Marks a column as covered by taking its header out of the header list. */
+        void coverColumn(int header) {
+            right[left[header]] = right[header];
+            left[right[header]] = left[header];
+            coveredColumns.push_back(header);
+        }
+
+        void uncoverColumns(size_t mark) {
+            while (coveredColumns.size() > mark) {
+                int header = coveredColumns.back();
+                coveredColumns.pop_back();
+                right[left[header]] = header;
+                left[right[header]] = header;
+            }
+        }
+
+        /* Gives supplies to the city whose row contains the given node. */
+        void selectRow(int node) {
+            int current = node;
+            do {
+                if (isActive(column[current])) coverColumn(column[current]);
+                current = right[current];
+            } while (current != node);
+        }
+
+        /* Rules out the row containing the given node by taking all of its nodes out of
+         * their columns.
+         */
+        void excludeRow(int node) {
+            int current = node;
+            do {
+                down[up[current]] = down[current];
+                up[down[current]] = up[current];
+                size[column[current]]--;
+                current = right[current];
+            } while (current != node);
+            excludedRows.push_back(node);
+        }
+
+        void includeRows(size_t mark) {
+            while (excludedRows.size() > mark) {
+                int node = excludedRows.back();
+                excludedRows.pop_back();
+
+                int current = node;
+                do {
+                    current = left[current];
+                    size[column[current]]++;
+                    down[up[current]] = current;
+                    up[down[current]] = current;
+                } while (current != node);
+            }
+        }
+
+        /* Whether a column's header is still in the header list. */
+        bool isActive(int header) const {
+            return right[left[header]] == header;
+        }
+
+        /* The uncovered column with the fewest rows left, or the root if everything is
+         * covered.
+         */
+        int mostConstrainedColumn() const {
+            int best = 0;
+            for (int header = right[0]; header != 0; header = right[header]) {
+                if (best == 0 || size[header] < size[best]) best = header;
+            }
+            return best;
+        }
+    };
+
+    /* Repeatedly picks the column with the fewest ways of being covered and tries each
+     * of its rows in turn. Once a row has been tried, it's excluded for the rest of that
+     * column's rows, since any solution using it has already been found.
+     */
+    bool DancingLinks::search(vector<int>& chosen, SearchStats* stats, const CancelFlag* cancel) {
+        long long steps = 0;
+        bool found = false;
+
+        bool entering = true;  // Whether we've just arrived at a new node of the search
+        while (true) {
+            if (entering) {
+                entering = false;
+                int depth = frames.size();
+                STATS_RECORD(stats, visitNode(depth));
+
+                if (cancel && ++steps % kCancelCheckInterval == 0 && cancel->load(memory_order_relaxed)) {
+                    break;
+                }
+
+                int header = mostConstrainedColumn();
+                if (header == 0) {
+                    chosen.clear();
+                    for (const Frame& frame: frames) {
+                        chosen.push_back(rowOf[frame.node]);
+                    }
+                    found = true;
+                    break;
+                }
+                if (depth == budget) {
+                    STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+                } else if (size[header] == 0) {
+                    STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                } else {
+                    STATS_RECORD(stats, branch(size[header]));
+                    frames.push_back({ header, header, coveredColumns.size(), excludedRows.size() });
+                }
+            }
+
+            if (frames.empty()) break;
+
+            /* Move on to the next row of the deepest column with something left. */
+            Frame& frame = frames.back();
+            if (frame.node != frame.header) {
+                uncoverColumns(frame.coveredMark);
+                excludeRow(frame.node);
+            }
+
+            frame.node = down[frame.node];
+            if (frame.node == frame.header) {
+                includeRows(frame.excludedMark);
+                frames.pop_back();
+                continue;
+            }
+
+            frame.coveredMark = coveredColumns.size();
+            selectRow(frame.node);
+            entering = true;
+        }
+
+        /* Put everything back the way it was. */
+        uncoverColumns(0);
+        includeRows(0);
+        frames.clear();
+        return found;
+    }
+}
+
+bool dancingLinksSearch(const DisasterGraph& graph, int numCities,
+                        vector<int>& chosen, SearchStats* stats,
+                        const CancelFlag* cancel) {
+    DisasterArena arena(DancingLinks::arenaBytesFor(graph, numCities));
+    DancingLinks links(graph, numCities, arena);
+    return links.search(chosen, stats, cancel);
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "DisasterAllocations.h"
+#include <iostream>
+
+STUDENT_TEST("Dancing links puts everything back after a search.") {
+    /* The "Don't be Greedy" network. */
+    Map<string, Set<string>> map = {
+        { "A", { "B" } },
+        { "B", { "A", "C", "F" } },
+        { "C", { "B", "D", "F", "G" } },
+        { "D", { "C", "E", "G" } },
+        { "E", { "D" } },
+        { "F", { "B", "C" } },
+        { "G", { "C", "D" } },
+    };
+    DisasterGraph graph = toGraph(map);
+
+    for (int numCities: { 1, 2 }) {
+        DisasterArena arena(DancingLinks::arenaBytesFor(graph, numCities));
+        DancingLinks links(graph, numCities, arena);
+        vector<int> original = links.links();
+
+        /* Search twice, to make sure the second search starts from a clean slate. */
+        for (int round = 0; round < 2; round++) {
+            vector<int> chosen;
+            EXPECT_EQUAL(links.search(chosen, nullptr, nullptr), numCities == 2);
+            if (numCities == 2) {
+                EXPECT_EQUAL(namesOf(graph, chosen), { "B", "D" });
+            }
+            EXPECT(links.links() == original);
+        }
+    }
+}
+
+STUDENT_TEST("Dancing links needs as few cities as the other solvers.") {
+    /* Rings, stars, and paths of various sizes. */
+    for (int n = 1; n <= 12; n++) {
+        Map<string, Set<string>> ring, star, path;
+        for (int i = 0; i < n; i++) {
+            string city = "City " + to_string(i);
+            string next = "City " + to_string((i + 1) % n);
+            ring[city]; star[city]; path[city];
+            if (n > 2 || (n == 2 && i == 0)) {
+                ring[city] += next;
+                ring[next] += city;
+            }
+            if (i > 0) {
+                star[city] += "City 0";
+                star["City 0"] += city;
+                path[city] += "City " + to_string(i - 1);
+                path["City " + to_string(i - 1)] += city;
+            }
+        }
+
+        for (const auto& network: { ring, star, path }) {
+            for (int k = 0; k <= n; k++) {
+                auto expected = placeEmergencySupplies(network, k, SolverMode::ITERATIVE);
+                auto result   = placeEmergencySupplies(network, k, SolverMode::DANCING_LINKS);
+                EXPECT_EQUAL(result != Nothing, expected != Nothing);
+                if (result != Nothing) {
+                    EXPECT(result.value().size() <= k);
+                }
+            }
+        }
+    }
+}
+
+STUDENT_TEST("Dancing links search doesn't allocate memory.") {
+    /* Without allocation counting, every count is zero and this would check nothing. */
+    if (!DisasterAllocations::isCounting()) {
+        cout << "Skipped: define DISASTER_COUNT_ALLOCATIONS in the .pro file to run this test." << endl;
+        return;
+    }
+
+    /* A long chain of triangles, each joined to the next. That takes a lot of search to
+     * find the best plan, and there are many ways to fail with one fewer city.
+     */
+    const int kNumTriangles = 12;
+    Map<string, Set<string>> network;
+    auto addRoad = [&](const string& one, const string& two) {
+        network[one] += two;
+        network[two] += one;
+    };
+    for (int i = 0; i < kNumTriangles; i++) {
+        string prefix = "T" + to_string(i) + "-";
+        addRoad(prefix + "A", prefix + "B");
+        addRoad(prefix + "B", prefix + "C");
+        addRoad(prefix + "C", prefix + "A");
+        if (i > 0) addRoad(prefix + "A", "T" + to_string(i - 1) + "-C");
+    }
+    DisasterGraph graph = toGraph(network);
+
+    for (int numCities: { kNumTriangles - 1, kNumTriangles }) {
+        DisasterArena arena(DancingLinks::arenaBytesFor(graph, numCities));
+        DancingLinks links(graph, numCities, arena);
+        EXPECT(arena.bytesUsed() <= arena.capacity());
+
+        /* Leave room for the answer, so that filling it in doesn't count. */
+        vector<int> chosen;
+        chosen.reserve(graph.numCities());
+
+        long long before = DisasterAllocations::count();
+        EXPECT_EQUAL(links.search(chosen, nullptr, nullptr), numCities == kNumTriangles);
+        EXPECT_EQUAL(DisasterAllocations::count() - before, 0);
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cmath>
+#include "gtypes.h"
+
+/* Square of the Euclidean distance between two points. Comparing these orders points by
+ * distance without taking any square roots.
+ */
+inline double squaredDistance(const GPoint& one, const GPoint& two) {
+    double dx = one.x - two.x;
+    double dy = one.y - two.y;
+    return dx * dx + dy * dy;
+}
+
+/* Euclidean distance between two points. */
+inline double distanceBetween(const GPoint& one, const GPoint& two) {
+    return std::sqrt(squaredDistance(one, two));
+}
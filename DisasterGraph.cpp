@@ -0,0 +1,41 @@
+#include "DisasterGraph.h"
+#include <algorithm>
+#include <unordered_map>
+using namespace std;
+
+DisasterGraph toGraph(const Map<string, Set<string>>& roadNetwork) {
+    DisasterGraph result;
+    result.names = roadNetwork.keys();
+
+    unordered_map<string, int> indices;
+    indices.reserve(result.names.size());
+    for (int i = 0; i < result.names.size(); i++) {
+        indices[result.names[i]] = i;
+    }
+
+    result.offsets.reserve(result.names.size() + 1);
+    result.offsets.push_back(0);
+    for (int i = 0; i < result.names.size(); i++) {
+        for (const string& dest: roadNetwork[result.names[i]]) {
+            auto itr = indices.find(dest);
+            if (itr != indices.end() && itr->second != i) {
+                result.neighbors.push_back(itr->second);
+            }
+        }
+
+        /* Set iterates in sorted order and names are numbered in sorted order, so
+         * each city's neighbors are already sorted and distinct.
+         */
+        result.offsets.push_back(int(result.neighbors.size()));
+    }
+
+    return result;
+}
+
+Set<string> namesOf(const DisasterGraph& graph, const vector<int>& cities) {
+    Set<string> result;
+    for (int city: cities) {
+        result += graph.names[city];
+    }
+    return result;
+}
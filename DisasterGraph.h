@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "map.h"
+#include "set.h"
+#include "vector.h"
+
+/**
+ * A compact, read-only form of a road network for the faster solvers to work with.
+ * Cities are numbered 0, 1, 2, ... in the order the Map iterates over them, which is
+ * the same order as roadNetwork.keys(). The roads out of each city are stored next to
+ * one another in a single array (compressed sparse row form), so walking over a city's
+ * neighbors touches one contiguous block of memory.
+ *
+ * Like placeEmergencySupplies, this assumes roads are bidirectional.
+ */
+struct DisasterGraph {
+    Vector<std::string> names;  // City number -> city name
+    std::vector<int> offsets;   // Roads out of city i live in neighbors[offsets[i] .. offsets[i + 1])
+    std::vector<int> neighbors;
+
+    /* A range of neighbors, usable in a range-based for loop. */
+    struct Range {
+        const int* first;
+        const int* last;
+
+        const int* begin() const { return first; }
+        const int* end()   const { return last;  }
+        int size()         const { return int(last - first); }
+    };
+
+    int numCities() const {
+        return names.size();
+    }
+
+    Range neighborsOf(int city) const {
+        return { neighbors.data() + offsets[city], neighbors.data() + offsets[city + 1] };
+    }
+
+    int degree(int city) const {
+        return offsets[city + 1] - offsets[city];
+    }
+};
+
+/**
+ * Builds the compact form of a road network. Roads leading to cities that aren't keys
+ * in the map are dropped, as are roads from a city to itself, since neither can affect
+ * which cities are covered.
+ *
+ * @param roadNetwork The network to convert.
+ * @return That network, with cities numbered in alphabetical order.
+ */
+DisasterGraph toGraph(const Map<std::string, Set<std::string>>& roadNetwork);
+
+/**
+ * Given city numbers from a graph, returns the names of those cities.
+ */
+Set<std::string> namesOf(const DisasterGraph& graph, const std::vector<int>& cities);
@@ -0,0 +1,595 @@
+#include "DisasterGrid.h"
+#include "DisasterSolvers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+using namespace std;
+
+namespace {
+    /* Largest number of profiles the dynamic program will track at once before giving
+     * up on the grid and deferring to the backtracker.
+     */
+    const size_t kMaxProfiles = 1 << 21;
+
+    /* What the dynamic program remembers about each cell in the profile. Each takes
+     * two bits in a packed 64-bit profile.
+     */
+    enum CellState : uint64_t {
+        NEEDY   = 0,  // No supplies, not covered yet; the cell to the right or below must cover it
+        COVERED = 1,  // No supplies, but covered (or empty, and so needing nothing)
+        CHOSEN  = 2   // Has supplies
+    };
+
+    CellState stateAt(uint64_t profile, int col) {
+        return CellState((profile >> (2 * col)) & 3);
+    }
+
+    uint64_t withState(uint64_t profile, int col, CellState state) {
+        return (profile & ~(uint64_t(3) << (2 * col))) | (uint64_t(state) << (2 * col));
+    }
+
+    /* Whether there's a road between two cities. Neighbor lists are sorted. */
+    bool hasRoad(const DisasterGraph& graph, int from, int to) {
+        auto range = graph.neighborsOf(from);
+        return binary_search(range.begin(), range.end(), to);
+    }
+
+    /* Confirms every road in the network joins adjacent cells of the layout. */
+    bool roadsFitLayout(const DisasterGraph& graph, const GridLayout& layout) {
+        vector<int> rowOf(graph.numCities(), -1), colOf(graph.numCities(), -1);
+        for (int row = 0; row < layout.rows; row++) {
+            for (int col = 0; col < layout.cols; col++) {
+                int city = layout.cells[row * layout.cols + col];
+                if (city != -1) {
+                    rowOf[city] = row;
+                    colOf[city] = col;
+                }
+            }
+        }
+
+        for (int city = 0; city < graph.numCities(); city++) {
+            if (rowOf[city] == -1) return false;
+            for (int neighbor: graph.neighborsOf(city)) {
+                if (abs(rowOf[city] - rowOf[neighbor]) + abs(colOf[city] - colOf[neighbor]) != 1) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /* Breadth-first search distances from a city. */
+    vector<int> distancesFrom(const DisasterGraph& graph, int source) {
+        vector<int> result(graph.numCities(), -1);
+        deque<int> worklist = { source };
+        result[source] = 0;
+
+        while (!worklist.empty()) {
+            int curr = worklist.front();
+            worklist.pop_front();
+
+            for (int next: graph.neighborsOf(curr)) {
+                if (result[next] == -1) {
+                    result[next] = result[curr] + 1;
+                    worklist.push_back(next);
+                }
+            }
+        }
+        return result;
+    }
+
+    /* Swaps rows and columns, so the dynamic program can sweep along the long side. */
+    GridLayout transpose(const GridLayout& layout) {
+        GridLayout result;
+        result.rows = layout.cols;
+        result.cols = layout.rows;
+        result.cells.resize(layout.cells.size());
+        for (int row = 0; row < layout.rows; row++) {
+            for (int col = 0; col < layout.cols; col++) {
+                result.cells[col * result.cols + row] = layout.cells[row * layout.cols + col];
+            }
+        }
+        return result;
+    }
+
+    /* One profile reached by the dynamic program, and the fewest supplies needed to get there. */
+    struct Entry {
+        uint64_t profile;
+        int cost;
+    };
+
+    /* How an entry was reached: the index of the entry it came from at the previous cell,
+     * shifted left one bit, with the low bit set if this cell got supplies.
+     */
+    using Backlink = uint32_t;
+
+    /* Result codes for the dynamic program. */
+    const int kNoSolution = -1;
+    const int kGaveUp     = -2;
+    const int kCancelled  = -3;
+
+    /* Carries the dynamic program across the grid one cell at a time. */
+    class ProfileSweep {
+    public:
+        ProfileSweep(const DisasterGraph& graph, const GridLayout& layout, int numCities)
+            : graph(graph), layout(layout), numCities(numCities) {}
+
+        /* Given the entries reached just before a cell is decided, fills in the entries
+         * reached just after. If links isn't null, it's filled in with how each of those
+         * entries was reached.
+         */
+        void advance(int cell, const vector<Entry>& curr, vector<Entry>& next,
+                     vector<Backlink>* links, SearchStats* stats);
+
+    private:
+        const DisasterGraph& graph;
+        const GridLayout& layout;
+        int numCities;
+
+        /* Open-addressed hash table from profiles to their indices in next, or -1 for
+         * an empty slot. There are millions of lookups per row on wide grids, and
+         * probing one flat array is several times faster than a node-based map.
+         */
+        vector<int> slots;
+        int slotBits = 0;
+
+        int& slotFor(uint64_t profile, const vector<Entry>& next);
+    };
+
+    int& ProfileSweep::slotFor(uint64_t profile, const vector<Entry>& next) {
+        const size_t mask = slots.size() - 1;
+        size_t slot = size_t((profile * 0x9E3779B97F4A7C15ull) >> (64 - slotBits));
+        while (slots[slot] != -1 && next[slots[slot]].profile != profile) {
+            slot = (slot + 1) & mask;
+        }
+        return slots[slot];
+    }
+
+    void ProfileSweep::advance(int cell, const vector<Entry>& curr, vector<Entry>& next,
+                               vector<Backlink>* links, SearchStats* stats) {
+        const int width = layout.cols;
+        int row = cell / width, col = cell % width;
+        int city  = layout.cells[cell];
+        int above = row > 0? layout.cells[cell - width] : -1;
+        int left  = col > 0? layout.cells[cell - 1]     : -1;
+        bool roadUp   = city != -1 && above != -1 && hasRoad(graph, city, above);
+        bool roadLeft = city != -1 && left  != -1 && hasRoad(graph, city, left);
+
+        /* Each entry leads to at most two more, so this keeps the table at most half full. */
+        slotBits = 4;
+        while ((size_t(1) << slotBits) < 4 * curr.size()) slotBits++;
+        slots.assign(size_t(1) << slotBits, -1);
+        next.clear();
+        if (links) links->clear();
+
+        auto offer = [&](uint64_t profile, int cost, int parent, bool chose) {
+            if (cost > numCities) {
+                STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+                return;
+            }
+            Backlink link = (Backlink(parent) << 1) | (chose? 1 : 0);
+            int& index = slotFor(profile, next);
+            if (index == -1) {
+                index = int(next.size());
+                next.push_back({ profile, cost });
+                if (links) links->push_back(link);
+            } else if (cost < next[index].cost) {
+                next[index].cost = cost;
+                if (links) (*links)[index] = link;
+            }
+        };
+
+        for (int i = 0; i < int(curr.size()); i++) {
+            STATS_RECORD(stats, visitNode(cell));
+            const Entry& entry = curr[i];
+            CellState up     = stateAt(entry.profile, col);
+            CellState before = col > 0? stateAt(entry.profile, col - 1) : COVERED;
+
+            /* Option 1: No supplies here. The cell above is about to leave the profile,
+             * so it had better be covered already.
+             */
+            if (up == NEEDY) {
+                STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+            } else {
+                CellState here = COVERED;
+                if (city != -1 && !(roadUp && up == CHOSEN) && !(roadLeft && before == CHOSEN)) {
+                    here = NEEDY;
+                }
+                offer(withState(entry.profile, col, here), entry.cost, i, false);
+            }
+
+            /* Option 2: Supplies here, covering the cells above and to the left. */
+            if (city != -1) {
+                STATS_RECORD(stats, branch(2));
+                if (up == NEEDY && !roadUp) {
+                    STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+                } else {
+                    uint64_t profile = entry.profile;
+                    if (roadLeft && before == NEEDY) {
+                        profile = withState(profile, col - 1, COVERED);
+                    }
+                    offer(withState(profile, col, CHOSEN), entry.cost + 1, i, true);
+                }
+            } else {
+                STATS_RECORD(stats, branch(1));
+            }
+        }
+    }
+
+    /* Runs the profile dynamic program, returning the size of the smallest cover if it's at
+     * most numCities, kNoSolution if there's no such cover, kGaveUp if the program grew
+     * too large, or kCancelled if it was cancelled.
+     */
+    int solveProfiles(const DisasterGraph& graph, const GridLayout& layout, int numCities,
+                      vector<int>& chosen, SearchStats* stats, const CancelFlag* cancel) {
+        const int width = layout.cols;
+        const int rows  = layout.rows;
+        ProfileSweep sweep(graph, layout, numCities);
+
+        /* Runs the program across one row, checking for cancellation at each cell. The
+         * entries passed in are replaced by the ones reached at the end of the row.
+         */
+        vector<Entry> next;
+        auto sweepRow = [&](int row, vector<Entry>& entries,
+                            vector<vector<Backlink>>* links, SearchStats* rowStats) {
+            for (int col = 0; col < width; col++) {
+                if (cancel && cancel->load(memory_order_relaxed)) return kCancelled;
+                sweep.advance(row * width + col, entries, next, links? &(*links)[col] : nullptr, rowStats);
+                if (next.size() > kMaxProfiles) return kGaveUp;
+                swap(entries, next);
+            }
+            return 0;
+        };
+
+        /* The profile packs the state of the last `width` cells decided, with column j's
+         * slot holding whichever cell in column j was decided most recently. A virtual row
+         * of empty cells above the grid starts things off.
+         */
+        uint64_t initial = 0;
+        for (int col = 0; col < width; col++) {
+            initial = withState(initial, col, COVERED);
+        }
+
+        /* Remembering how every entry at every cell was reached would take memory for the
+         * whole grid. Instead, save the entries at the start of every stride-th row, and
+         * recompute what's needed on the way back. That keeps about 2 sqrt(rows) rows'
+         * worth of entries around, for the price of running the program three times.
+         */
+        const int stride = max(1, int(ceil(sqrt(double(rows)))));
+        vector<vector<Entry>> checkpoints;
+        vector<Entry> curr = { { initial, 0 } };
+        for (int row = 0; row < rows; row++) {
+            if (row % stride == 0) checkpoints.push_back(curr);
+            int status = sweepRow(row, curr, nullptr, stats);
+            if (status != 0) return status;
+        }
+
+        /* Find the cheapest final profile with nothing left uncovered. */
+        int best = -1;
+        for (int i = 0; i < int(curr.size()); i++) {
+            bool allCovered = true;
+            for (int col = 0; col < width; col++) {
+                if (stateAt(curr[i].profile, col) == NEEDY) allCovered = false;
+            }
+            if (allCovered && (best == -1 || curr[i].cost < curr[best].cost)) {
+                best = i;
+            }
+        }
+        if (best == -1) return kNoSolution;
+
+        /* Walk back through the cells to see which ones got supplies. The program makes
+         * the same entries in the same order each time it's run from the same place, so
+         * an entry's index at the start of a row is also its index at the end of the
+         * row before.
+         */
+        STATS_RECORD(stats, reconstruction.start());
+        chosen.clear();
+        vector<vector<Entry>> rowStarts;
+        vector<vector<Backlink>> links(width);
+        for (int first = (int(checkpoints.size()) - 1) * stride, index = best; first >= 0; first -= stride) {
+            int end = min(rows, first + stride);
+
+            /* Recompute where each row in this stretch starts... */
+            rowStarts.assign(1, checkpoints[first / stride]);
+            for (int row = first; row + 1 < end; row++) {
+                rowStarts.push_back(rowStarts.back());
+                if (sweepRow(row, rowStarts.back(), nullptr, nullptr) == kCancelled) return kCancelled;
+            }
+
+            /* ...then redo the rows from last to first, this time noting how each entry
+             * was reached.
+             */
+            for (int row = end - 1; row >= first; row--) {
+                curr = rowStarts[row - first];
+                if (sweepRow(row, curr, &links, nullptr) == kCancelled) return kCancelled;
+                for (int col = width - 1; col >= 0; col--) {
+                    Backlink link = links[col][index];
+                    if (link & 1) chosen.push_back(layout.cells[row * width + col]);
+                    index = int(link >> 1);
+                }
+            }
+        }
+        STATS_RECORD(stats, reconstruction.stop());
+        return int(chosen.size());
+    }
+}
+
+bool findGridLayout(const DisasterGraph& graph, GridLayout& layout) {
+    const int n = graph.numCities();
+    if (n == 0) return false;
+
+    if (n == 1) {
+        layout = { 1, 1, { 0 } };
+        return true;
+    }
+
+    /* In a grid with at least two rows and columns, the corners are exactly the cities with
+     * two roads. In a single row, the ends are the cities with one road.
+     */
+    int minDegree = n;
+    for (int city = 0; city < n; city++) {
+        minDegree = min(minDegree, graph.degree(city));
+    }
+    if (minDegree == 0 || minDegree > 2) return false;
+
+    vector<int> corners;
+    for (int city = 0; city < n; city++) {
+        if (graph.degree(city) == minDegree) corners.push_back(city);
+    }
+    if (corners.size() != (minDegree == 1? 2u : 4u)) return false;
+
+    /* Measure from one corner to the nearest other one to find the width. */
+    vector<int> fromFirst = distancesFrom(graph, corners[0]);
+    int other = -1;
+    for (int corner: corners) {
+        if (corner == corners[0] || fromFirst[corner] == -1) continue;
+        if (other == -1 || fromFirst[corner] < fromFirst[other]) other = corner;
+    }
+    if (other == -1) return false;
+
+    int cols = fromFirst[other] + 1;
+    if (n % cols != 0) return false;
+    int rows = n / cols;
+
+    /* A city at row r, column c is r + c steps from the first corner and r + (cols - 1 - c)
+     * steps from the other, which pins down where it is.
+     */
+    vector<int> fromOther = distancesFrom(graph, other);
+    layout.rows = rows;
+    layout.cols = cols;
+    layout.cells.assign(n, -1);
+    for (int city = 0; city < n; city++) {
+        if (fromFirst[city] == -1) return false;
+        int sum  = fromFirst[city] + fromOther[city] - (cols - 1);
+        int diff = fromFirst[city] - fromOther[city] + (cols - 1);
+        if (sum % 2 != 0 || diff % 2 != 0) return false;
+
+        int row = sum / 2, col = diff / 2;
+        if (row < 0 || row >= rows || col < 0 || col >= cols) return false;
+        if (layout.cells[row * cols + col] != -1) return false;
+        layout.cells[row * cols + col] = city;
+    }
+
+    /* Every cell is filled and every road is between adjacent cells. A grid this shape has
+     * exactly this many roads, so if the counts match, none are missing.
+     */
+    int numRoads = rows * (cols - 1) + cols * (rows - 1);
+    return roadsFitLayout(graph, layout) && int(graph.neighbors.size()) == 2 * numRoads;
+}
+
+bool findGridLayout(const DisasterGraph& graph,
+                    const Map<string, GPoint>& locations,
+                    GridLayout& layout) {
+    const int n = graph.numCities();
+    if (n == 0) return false;
+
+    vector<double> xs, ys;
+    vector<GPoint> where(n);
+    for (int city = 0; city < n; city++) {
+        if (!locations.containsKey(graph.names[city])) return false;
+        where[city] = locations[graph.names[city]];
+        xs.push_back(where[city].x);
+        ys.push_back(where[city].y);
+    }
+
+    sort(xs.begin(), xs.end());
+    xs.erase(unique(xs.begin(), xs.end()), xs.end());
+    sort(ys.begin(), ys.end());
+    ys.erase(unique(ys.begin(), ys.end()), ys.end());
+
+    /* Don't treat a scattering of points as a mostly-empty grid. */
+    if (xs.size() * ys.size() > 2 * size_t(n)) return false;
+
+    layout.rows = int(ys.size());
+    layout.cols = int(xs.size());
+    layout.cells.assign(layout.rows * layout.cols, -1);
+    for (int city = 0; city < n; city++) {
+        int row = int(lower_bound(ys.begin(), ys.end(), where[city].y) - ys.begin());
+        int col = int(lower_bound(xs.begin(), xs.end(), where[city].x) - xs.begin());
+        if (layout.cells[row * layout.cols + col] != -1) return false;
+        layout.cells[row * layout.cols + col] = city;
+    }
+
+    return roadsFitLayout(graph, layout);
+}
+
+bool minimumGridCover(const DisasterGraph& graph, const GridLayout& layout,
+                      vector<int>& chosen, SearchStats* stats) {
+    /* Sweep along the longer side so the profile is as narrow as possible. */
+    GridLayout oriented = layout.cols > layout.rows? transpose(layout) : layout;
+    if (oriented.cols > kMaxGridWidth) return false;
+
+    return solveProfiles(graph, oriented, graph.numCities(), chosen, stats, nullptr) >= 0;
+}
+
+GridOutcome solveIfGrid(const DisasterGraph& graph, int numCities,
+                        vector<int>& chosen, SearchStats* stats,
+                        const CancelFlag* cancel) {
+    GridLayout layout;
+    if (!findGridLayout(graph, layout)) return GridOutcome::DEFERRED;
+
+    GridLayout oriented = layout.cols > layout.rows? transpose(layout) : layout;
+    if (oriented.cols > kMaxGridWidth) return GridOutcome::DEFERRED;
+
+    switch (solveProfiles(graph, oriented, numCities, chosen, stats, cancel)) {
+        case kNoSolution: return GridOutcome::NO_SOLUTION;
+        case kGaveUp:     return GridOutcome::DEFERRED;
+        case kCancelled:  return GridOutcome::CANCELLED;
+        default:          return GridOutcome::SOLVED;
+    }
+}
+
+bool gridSearch(const DisasterGraph& graph, int numCities,
+                vector<int>& chosen, SearchStats* stats,
+                const CancelFlag* cancel) {
+    switch (solveIfGrid(graph, numCities, chosen, stats, cancel)) {
+        case GridOutcome::SOLVED:   return true;
+        case GridOutcome::DEFERRED: return iterativeSearch(graph, numCities, chosen, stats, cancel);
+        default:                    return false;
+    }
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+
+namespace {
+    /* Builds a rows x cols grid with cities named by row letter and column number. */
+    Map<string, Set<string>> makeGrid(int rows, int cols) {
+        Map<string, Set<string>> result;
+        auto name = [](int row, int col) {
+            return string(1, char('A' + row)) + to_string(col);
+        };
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                result[name(row, col)];
+                if (row + 1 < rows) {
+                    result[name(row, col)]     += name(row + 1, col);
+                    result[name(row + 1, col)] += name(row, col);
+                }
+                if (col + 1 < cols) {
+                    result[name(row, col)]     += name(row, col + 1);
+                    result[name(row, col + 1)] += name(row, col);
+                }
+            }
+        }
+        return result;
+    }
+
+    /* Builds a rows x cols grid directly in compact form, for grids with too many rows
+     * to name by letter.
+     */
+    DisasterGraph makeGridGraph(int rows, int cols) {
+        DisasterGraph graph;
+        graph.offsets.push_back(0);
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < cols; col++) {
+                int city = row * cols + col;
+                graph.names += to_string(city);
+                if (row > 0)        graph.neighbors.push_back(city - cols);
+                if (col > 0)        graph.neighbors.push_back(city - 1);
+                if (col + 1 < cols) graph.neighbors.push_back(city + 1);
+                if (row + 1 < rows) graph.neighbors.push_back(city + cols);
+                graph.offsets.push_back(int(graph.neighbors.size()));
+            }
+        }
+        return graph;
+    }
+
+    bool coversEverything(const DisasterGraph& graph, const vector<int>& chosen) {
+        vector<bool> covered(graph.numCities());
+        for (int city: chosen) {
+            covered[city] = true;
+            for (int neighbor: graph.neighborsOf(city)) covered[neighbor] = true;
+        }
+        return all_of(covered.begin(), covered.end(), [](bool b) { return b; });
+    }
+}
+
+STUDENT_TEST("Recognizes grids from their roads alone.") {
+    GridLayout layout;
+    EXPECT(findGridLayout(toGraph(makeGrid(6, 6)), layout));
+    EXPECT_EQUAL(layout.rows * layout.cols, 36);
+
+    EXPECT(findGridLayout(toGraph(makeGrid(3, 7)), layout));
+    EXPECT_EQUAL(min(layout.rows, layout.cols), 3);
+
+    EXPECT(findGridLayout(toGraph(makeGrid(1, 5)), layout));
+    EXPECT(findGridLayout(toGraph(makeGrid(2, 2)), layout));
+
+    /* Removing one road breaks the pattern. */
+    auto broken = makeGrid(4, 4);
+    broken["B1"] -= "B2";
+    broken["B2"] -= "B1";
+    EXPECT(!findGridLayout(toGraph(broken), layout));
+
+    /* So does a triangle. */
+    EXPECT(!findGridLayout(toGraph({ { "A", { "B", "C" } }, { "B", { "A", "C" } }, { "C", { "A", "B" } } }), layout));
+}
+
+STUDENT_TEST("Grid dynamic program finds minimum covers.") {
+    /* Known domination numbers of square grids. */
+    vector<int> expected = { 0, 1, 2, 3, 4, 7, 10, 12, 16 };
+    for (int size = 1; size < int(expected.size()); size++) {
+        DisasterGraph graph = toGraph(makeGrid(size, size));
+        vector<int> chosen;
+        EXPECT(gridSearch(graph, graph.numCities(), chosen));
+        EXPECT_EQUAL(int(chosen.size()), expected[size]);
+        EXPECT(!gridSearch(graph, expected[size] - 1, chosen));
+    }
+}
+
+STUDENT_TEST("Grid dynamic program handles grids with missing cities and roads.") {
+    /* A 3 x 3 grid with its middle city missing is a ring of eight cities. */
+    auto ring = makeGrid(3, 3);
+    for (string neighbor: ring["B1"]) {
+        ring[neighbor] -= "B1";
+    }
+    ring.remove("B1");
+
+    Map<string, GPoint> locations;
+    for (string city: ring) {
+        locations[city] = { double(city[1] - '0'), double(city[0] - 'A') };
+    }
+
+    DisasterGraph graph = toGraph(ring);
+    GridLayout layout;
+    EXPECT(findGridLayout(graph, locations, layout));
+
+    vector<int> chosen;
+    EXPECT(minimumGridCover(graph, layout, chosen));
+    EXPECT_EQUAL(int(chosen.size()), 3);
+}
+
+STUDENT_TEST("Grid dynamic program handles long, wide grids quickly.") {
+    DisasterGraph graph = toGraph(makeGrid(40, 9));
+    vector<int> chosen;
+    EXPECT_COMPLETES_IN(5.0,
+        EXPECT(gridSearch(graph, graph.numCities(), chosen));
+    );
+    EXPECT(coversEverything(graph, chosen));
+}
+
+STUDENT_TEST("Grid dynamic program isn't limited in how many rows it takes.") {
+    /* The program only keeps a few rows' worth of profiles around at a time, so long
+     * grids are fine as long as they're narrow.
+     */
+    DisasterGraph graph = makeGridGraph(5000, 6);
+    GridLayout layout;
+    EXPECT(findGridLayout(graph, layout));
+
+    vector<int> chosen;
+    EXPECT(minimumGridCover(graph, layout, chosen));
+    EXPECT(coversEverything(graph, chosen));
+}
+
+STUDENT_TEST("Grid dynamic program can be cancelled.") {
+    /* Solving this would take minutes. */
+    DisasterGraph graph = toGraph(makeGrid(kMaxGridWidth, kMaxGridWidth));
+    vector<int> chosen;
+
+    CancelFlag cancel(true);
+    EXPECT_COMPLETES_IN(1.0,
+        EXPECT(!gridSearch(graph, graph.numCities(), chosen, nullptr, &cancel));
+    );
+}
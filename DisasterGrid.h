@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "DisasterGraph.h"
+#include "DisasterSolvers.h"
+#include "DisasterStats.h"
+#include "map.h"
+#include "gtypes.h"
+
+/* Widest grid the profile dynamic program will take on, counting along the shorter side.
+ * The number of profiles it tracks grows by a factor of about 2.4 per column, to nearly
+ * two million at this width, and any wider grid would need more than it has room for.
+ * There's no limit on the number of rows: time grows in proportion to it and memory with
+ * its square root. Each row takes about a twentieth of a second at width 12, and about
+ * ten seconds at width 16.
+ */
+const int kMaxGridWidth = 16;
+
+/**
+ * Where each city of a network sits in a rows x cols lattice. Every road in the network
+ * must join two cells that are next to each other horizontally or vertically, but cells
+ * may be empty and neighboring cells needn't have a road between them, so this can
+ * describe grids with missing cities or roads as well as perfect grids.
+ */
+struct GridLayout {
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> cells; // Row-major; the city number in each cell, or -1 if empty.
+};
+
+/**
+ * Determines whether a network is a complete rectangular grid (including a single path
+ * of cities, or a lone city) just by looking at how its cities are connected.
+ *
+ * @param graph  The network to inspect.
+ * @param layout Filled in with the grid layout, if one is found.
+ * @return Whether the network is a grid.
+ */
+bool findGridLayout(const DisasterGraph& graph, GridLayout& layout);
+
+/**
+ * Determines whether a network is laid out on a grid, possibly with some cities or roads
+ * missing, using the locations of its cities. Cities sharing an x coordinate are taken to
+ * be in the same column, and cities sharing a y coordinate to be in the same row.
+ *
+ * @param graph     The network to inspect.
+ * @param locations Where each city is.
+ * @param layout    Filled in with the grid layout, if one is found.
+ * @return Whether the network fits on a grid.
+ */
+bool findGridLayout(const DisasterGraph& graph,
+                    const Map<std::string, GPoint>& locations,
+                    GridLayout& layout);
+
+/**
+ * Finds a smallest set of cities covering a grid-shaped network, using a dynamic program
+ * that sweeps across the grid one cell at a time while remembering only the state of the
+ * most recent row's worth of cells.
+ *
+ * @param graph  The network.
+ * @param layout Where each city sits in the grid.
+ * @param chosen Filled in with the cities to use.
+ * @return Whether the dynamic program succeeded. It gives up, returning false, if the
+ *         grid is more than kMaxGridWidth cells wide in both directions.
+ */
+bool minimumGridCover(const DisasterGraph& graph, const GridLayout& layout,
+                      std::vector<int>& chosen, SearchStats* stats = nullptr);
+
+/* What came of trying the grid dynamic program on a network. */
+enum class GridOutcome {
+    SOLVED,       // The network is a grid, and a smallest cover within budget was found.
+    NO_SOLUTION,  // The network is a grid, and no cover fits in the budget.
+    CANCELLED,    // The dynamic program was cancelled before it finished.
+    DEFERRED      // The network isn't a grid, or the dynamic program gave up on it.
+};
+
+/**
+ * Works out whether a network is a complete grid and, if so, runs the grid dynamic
+ * program on it. Only when this returns SOLVED is chosen filled in.
+ */
+GridOutcome solveIfGrid(const DisasterGraph& graph, int numCities,
+                        std::vector<int>& chosen, SearchStats* stats = nullptr,
+                        const CancelFlag* cancel = nullptr);
+
+/**
+ * Engine for SolverMode::GRID. If the network is a complete grid, solves it with the grid
+ * dynamic program, in which case any solution found uses as few cities as possible.
+ * Otherwise, or if the dynamic program gives up, defers to the iterative backtracker.
+ */
+bool gridSearch(const DisasterGraph& graph, int numCities,
+                std::vector<int>& chosen, SearchStats* stats = nullptr,
+                const CancelFlag* cancel = nullptr);
@@ -0,0 +1,217 @@
+#include "DisasterSolvers.h"
+using namespace std;
+
+namespace {
+    /* How many nodes to visit between checks for cancellation. */
+    const long long kCancelCheckInterval = 4096;
+
+    /* What's been decided about the city at a given depth of the search. */
+    enum Decision : char {
+        EXCLUDED,   // Tried leaving the city out; including it is next.
+        INCLUDED    // Tried both; time to undo and back up.
+    };
+
+    /* Working state for the search. Everything here is sized up front, so the search
+     * itself never allocates.
+     */
+    struct SearchState {
+        const DisasterGraph& graph;
+        vector<Decision> decisions;  // Decision at each depth
+        vector<int> trail;           // Cities with supplies, in the order chosen
+        vector<int> coverCount;      // How many chosen cities cover each city
+        int numUncovered;
+
+        /* finalizedAt[offsets[d] .. offsets[d + 1]) are the cities whose last chance
+         * to be covered is the decision about city d.
+         */
+        vector<int> finalizedOffsets;
+        vector<int> finalizedAt;
+
+        explicit SearchState(const DisasterGraph& graph) : graph(graph) {
+            int n = graph.numCities();
+            decisions.resize(n);
+            trail.reserve(n);
+            coverCount.assign(n, 0);
+            numUncovered = n;
+
+            /* Bucket each city by the highest-numbered city that could cover it. */
+            vector<int> lastChance(n);
+            finalizedOffsets.assign(n + 1, 0);
+            for (int city = 0; city < n; city++) {
+                lastChance[city] = city;
+                for (int neighbor: graph.neighborsOf(city)) {
+                    lastChance[city] = max(lastChance[city], neighbor);
+                }
+                finalizedOffsets[lastChance[city] + 1]++;
+            }
+            for (int i = 0; i < n; i++) {
+                finalizedOffsets[i + 1] += finalizedOffsets[i];
+            }
+
+            finalizedAt.resize(n);
+            vector<int> next(finalizedOffsets.begin(), finalizedOffsets.end() - 1);
+            for (int city = 0; city < n; city++) {
+                finalizedAt[next[lastChance[city]]++] = city;
+            }
+        }
+
+        /* Adjusts coverage counts for a city's neighborhood. */
+        void cover(int city, int delta) {
+            auto adjust = [&](int target) {
+                if (delta > 0 && coverCount[target] == 0) numUncovered--;
+                coverCount[target] += delta;
+                if (delta < 0 && coverCount[target] == 0) numUncovered++;
+            };
+
+            adjust(city);
+            for (int neighbor: graph.neighborsOf(city)) {
+                adjust(neighbor);
+            }
+        }
+
+        void choose(int city) {
+            trail.push_back(city);
+            cover(city, +1);
+        }
+
+        void unchoose() {
+            cover(trail.back(), -1);
+            trail.pop_back();
+        }
+
+        /* Whether the decision just made about city depth - 1 left some city that can
+         * no longer be covered.
+         */
+        bool leftCityUncoverable(int depth) const {
+            if (depth == 0) return false;
+            for (int i = finalizedOffsets[depth - 1]; i < finalizedOffsets[depth]; i++) {
+                if (coverCount[finalizedAt[i]] == 0) return true;
+            }
+            return false;
+        }
+    };
+}
+
+bool iterativeSearch(const DisasterGraph& graph, int numCities,
+                     vector<int>& chosen, SearchStats* stats,
+                     const CancelFlag* cancel) {
+    SearchState state(graph);
+    const int n = graph.numCities();
+
+    /* This mirrors canBeMadeDisasterReady, with each recursive call replaced by moving
+     * one level deeper and each return replaced by backing up to the nearest level
+     * with an untried option.
+     */
+    int depth = 0;
+    for (long long steps = 1; ; steps++) {
+        /* Checking for cancellation every so often keeps the cost of doing so low. */
+        if (cancel && steps % kCancelCheckInterval == 0 && cancel->load(memory_order_relaxed)) {
+            return false;
+        }
+
+        /* Visit the node at the current depth, seeing whether it's a dead end. */
+        STATS_RECORD(stats, visitNode(depth));
+        bool deadEnd = true;
+        if (int(state.trail.size()) > numCities) {
+            STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+        } else if (state.leftCityUncoverable(depth)) {
+            STATS_RECORD(stats, prune(PruneReason::UNCOVERABLE_CITY));
+        } else if (depth == n) {
+            if (state.numUncovered == 0) {
+                chosen = state.trail;
+                return true;
+            }
+            STATS_RECORD(stats, prune(PruneReason::UNCOVERED_CITY));
+        } else {
+            /* Not a dead end. Try leaving this city out first. */
+            STATS_RECORD(stats, branch(2));
+            state.decisions[depth] = EXCLUDED;
+            depth++;
+            deadEnd = false;
+        }
+
+        /* Back up to the closest level with something left to try. */
+        while (deadEnd) {
+            if (depth == 0) return false;
+            depth--;
+
+            if (state.decisions[depth] == EXCLUDED) {
+                state.decisions[depth] = INCLUDED;
+                state.choose(depth);
+                depth++;
+                deadEnd = false;
+            } else {
+                state.unchoose();
+            }
+        }
+    }
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <algorithm>
+
+STUDENT_TEST("Iterative solver finds the same answers as the recursive one.") {
+    Vector<string> cities = { "A", "B", "C", "D", "E", "F", "G" };
+    do {
+        /* The "Don't be Greedy" network:
+         *
+         *     0       4
+         *     |       |
+         *     1 - 2 - 3
+         *      \ / \ /
+         *       5   6
+         */
+        Map<string, Set<string>> map;
+        map[cities[0]] = { cities[1] };
+        map[cities[1]] = { cities[0], cities[2], cities[5] };
+        map[cities[2]] = { cities[1], cities[3], cities[5], cities[6] };
+        map[cities[3]] = { cities[2], cities[4], cities[6] };
+        map[cities[4]] = { cities[3] };
+        map[cities[5]] = { cities[1], cities[2] };
+        map[cities[6]] = { cities[2], cities[3] };
+
+        for (int numCities = 0; numCities <= 3; numCities++) {
+            EXPECT_EQUAL(placeEmergencySupplies(map, numCities, SolverMode::ITERATIVE),
+                         placeEmergencySupplies(map, numCities, SolverMode::RECURSIVE));
+        }
+    } while (next_permutation(cities.begin(), cities.end()));
+}
+
+STUDENT_TEST("Iterative solver handles a path of tens of thousands of cities.") {
+    /* A path this long would need one stack frame per city in the recursive solver. */
+    const int kNumCities = 30000;
+
+    Map<string, Set<string>> path;
+    for (int i = 0; i < kNumCities; i++) {
+        string name = "City " + to_string(i);
+        if (i > 0)              path[name] += "City " + to_string(i - 1);
+        if (i + 1 < kNumCities) path[name] += "City " + to_string(i + 1);
+    }
+
+    Optional<Set<string>> result;
+    EXPECT_COMPLETES_IN(10.0,
+        result = placeEmergencySupplies(path, kNumCities, SolverMode::ITERATIVE);
+    );
+    EXPECT_NOT_EQUAL(result, Nothing);
+}
+
+STUDENT_TEST("Iterative solver stops when cancelled.") {
+    /* Forty separate triangles can't be covered by thirty-nine supply locations, but
+     * there are a great many ways of trying.
+     */
+    Map<string, Set<string>> triangles;
+    for (int i = 0; i < 40; i++) {
+        Vector<string> corners = { to_string(i) + "A", to_string(i) + "B", to_string(i) + "C" };
+        for (const string& corner: corners) {
+            for (const string& other: corners) {
+                if (corner != other) triangles[corner] += other;
+            }
+        }
+    }
+
+    CancelFlag cancel(true);
+    EXPECT_COMPLETES_IN(1.0,
+        EXPECT_EQUAL(placeEmergencySupplies(triangles, 39, SolverMode::ITERATIVE, nullptr, &cancel), Nothing);
+    );
+}
@@ -0,0 +1,121 @@
+#include "DisasterKDTree.h"
+#include "DisasterGeometry.h"
+#include <algorithm>
+using namespace std;
+
+namespace {
+    double coordinate(const GPoint& point, int axis) {
+        return axis == 0? point.x : point.y;
+    }
+}
+
+KDTree::KDTree(const vector<GPoint>& points) : points(points), order(points.size()) {
+    for (int i = 0; i < int(order.size()); i++) {
+        order[i] = i;
+    }
+    build(0, order.size(), 0);
+}
+
+/* Puts the median of [low, high) along the axis in the middle, with everything before
+ * it no larger and everything after it no smaller, then does the same to each half
+ * along the other axis.
+ */
+void KDTree::build(int low, int high, int axis) {
+    if (high - low <= 1) return;
+
+    int mid = low + (high - low) / 2;
+    nth_element(order.begin() + low, order.begin() + mid, order.begin() + high, [&](int lhs, int rhs) {
+        return coordinate(points[lhs], axis) < coordinate(points[rhs], axis);
+    });
+    build(low, mid, 1 - axis);
+    build(mid + 1, high, 1 - axis);
+}
+
+int KDTree::nearest(const GPoint& query) const {
+    int best = -1;
+    double bestDistance = 0;
+    nearest(query, 0, order.size(), 0, best, bestDistance);
+    return best;
+}
+
+void KDTree::nearest(const GPoint& query, int low, int high, int axis,
+                     int& best, double& bestDistance) const {
+    if (low >= high) return;
+
+    int mid = low + (high - low) / 2;
+    int index = order[mid];
+    double distance = squaredDistance(query, points[index]);
+    if (best == -1 || distance < bestDistance || (distance == bestDistance && index < best)) {
+        best = index;
+        bestDistance = distance;
+    }
+
+    /* Search the side the query is on first; the other side can only help if the
+     * splitting line is within the best distance so far.
+     */
+    double offset = coordinate(query, axis) - coordinate(points[index], axis);
+    if (offset < 0) {
+        nearest(query, low, mid, 1 - axis, best, bestDistance);
+        if (offset * offset <= bestDistance) nearest(query, mid + 1, high, 1 - axis, best, bestDistance);
+    } else {
+        nearest(query, mid + 1, high, 1 - axis, best, bestDistance);
+        if (offset * offset <= bestDistance) nearest(query, low, mid, 1 - axis, best, bestDistance);
+    }
+}
+
+vector<int> KDTree::withinRadius(const GPoint& query, double radius) const {
+    vector<int> result;
+    withinRadius(query, radius, 0, order.size(), 0, result);
+    return result;
+}
+
+void KDTree::withinRadius(const GPoint& query, double radius, int low, int high, int axis,
+                          vector<int>& result) const {
+    if (low >= high) return;
+
+    int mid = low + (high - low) / 2;
+    int index = order[mid];
+    if (squaredDistance(query, points[index]) <= radius * radius) {
+        result.push_back(index);
+    }
+
+    double offset = coordinate(query, axis) - coordinate(points[index], axis);
+    if (offset <= radius)  withinRadius(query, radius, low, mid, 1 - axis, result);
+    if (offset >= -radius) withinRadius(query, radius, mid + 1, high, 1 - axis, result);
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+STUDENT_TEST("k-d tree queries match checking every point.") {
+    mt19937_64 engine(42);
+    for (int round = 0; round < 20; round++) {
+        /* Integer coordinates on a small grid, so there are plenty of ties. */
+        vector<GPoint> points;
+        int n = engine() % 200;
+        for (int i = 0; i < n; i++) {
+            points.push_back(GPoint(engine() % 30, engine() % 30));
+        }
+        KDTree tree(points);
+        EXPECT_EQUAL(tree.size(), n);
+
+        for (int query = 0; query < 50; query++) {
+            GPoint point((engine() % 400) / 10.0 - 5, (engine() % 400) / 10.0 - 5);
+            double radius = (engine() % 100) / 10.0;
+
+            int closest = -1;
+            vector<int> within;
+            for (int i = 0; i < n; i++) {
+                double distance = squaredDistance(point, points[i]);
+                if (closest == -1 || distance < squaredDistance(point, points[closest])) closest = i;
+                if (distance <= radius * radius) within.push_back(i);
+            }
+            EXPECT_EQUAL(tree.nearest(point), closest);
+
+            vector<int> found = tree.withinRadius(point, radius);
+            sort(found.begin(), found.end());
+            EXPECT(found == within);
+        }
+    }
+}
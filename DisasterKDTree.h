@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include "gtypes.h"
+
+/**
+ * A 2-d tree over a fixed set of points, answering nearest-point and within-a-radius
+ * queries without looking at every point. Points are referred to by their index in the
+ * vector the tree was built from.
+ * <p>
+ * The tree is stored implicitly: building it just reorders an array of indices so that
+ * the middle element of each range splits the rest of the range in half along alternating
+ * axes. That means no per-node allocations and queries that walk contiguous memory.
+ */
+class KDTree {
+public:
+    explicit KDTree(const std::vector<GPoint>& points);
+
+    /* Index of the point closest to the query point, or -1 if there are no points. Ties
+     * go to the lowest index.
+     */
+    int nearest(const GPoint& query) const;
+
+    /* Indices of all points at distance at most radius from the query point, in no
+     * particular order.
+     */
+    std::vector<int> withinRadius(const GPoint& query, double radius) const;
+
+    int size() const {
+        return int(points.size());
+    }
+
+private:
+    std::vector<GPoint> points;
+    std::vector<int> order;  // Point indices, arranged as the tree
+
+    void build(int low, int high, int axis);
+    void nearest(const GPoint& query, int low, int high, int axis,
+                 int& best, double& bestDistance) const;
+    void withinRadius(const GPoint& query, double radius, int low, int high, int axis,
+                      std::vector<int>& result) const;
+};
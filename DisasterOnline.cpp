@@ -0,0 +1,429 @@
+#include "DisasterOnline.h"
+#include "DisasterTrace.h"
+#include "error.h"
+#include <algorithm>
+#include <queue>
+using namespace std;
+
+namespace {
+    /* Compaction is asked for once this many cities, or a quarter of the network,
+     * whichever is more, have arrived since the last one. Re-solving the network costs
+     * time proportional to its size, so this keeps the compactor's work per arrival
+     * constant on average.
+     */
+    const int kMinCompactionInterval = 64;
+
+    /* Snapshots up to this size are solved exactly, within a bounded amount of work. */
+    const int kMaxExactCompactionCities = 64;
+    const long long kExactWorkLimit = 5000000;
+
+    using Roads = vector<vector<int>>;
+
+    /* Whether a city, or any city it has a road to, has supplies. */
+    bool isCovered(const Roads& roads, const vector<char>& supplied, int city) {
+        if (supplied[city]) return true;
+        for (int neighbor: roads[city]) {
+            if (supplied[neighbor]) return true;
+        }
+        return false;
+    }
+
+    /* Searches for independent dominating sets. Every city chosen must be uncovered when
+     * it's chosen, which is what keeps the chosen cities independent.
+     */
+    class IndependentCover {
+    public:
+        explicit IndependentCover(const Roads& roads) : roads(roads), coverCount(roads.size(), 0) {}
+
+        /* Greedy: repeatedly choose the uncovered city that covers the most uncovered
+         * cities. Gains only shrink, so they're kept in a lazily-updated priority queue.
+         */
+        vector<int> greedy() {
+            priority_queue<pair<int, int>> queue; // (gain, -city)
+            for (int city = 0; city < int(roads.size()); city++) {
+                queue.push({ int(roads[city].size()) + 1, -city });
+            }
+
+            vector<int> result;
+            while (!queue.empty()) {
+                int stored = queue.top().first;
+                int city = -queue.top().second;
+                queue.pop();
+
+                if (coverCount[city] > 0) continue; // Can't choose it and stay independent.
+                int gain = gainOf(city);
+                if (gain < stored) {
+                    queue.push({ gain, -city });
+                    continue;
+                }
+
+                result.push_back(city);
+                cover(city, +1);
+            }
+
+            for (int city: result) {
+                cover(city, -1);
+            }
+            return result;
+        }
+
+        /* Branch and bound for a smaller independent dominating set than the one given.
+         * Some city in the neighborhood of each uncovered city must be chosen, so we
+         * branch on the uncovered city with the fewest ways of being covered.
+         */
+        vector<int> improve(const vector<int>& incumbent) {
+            best = incumbent;
+            search();
+            return best;
+        }
+
+    private:
+        const Roads& roads;
+        vector<int> coverCount;
+        vector<int> current;
+        vector<int> best;
+        long long work = 0;
+
+        int gainOf(int city) const {
+            int result = (coverCount[city] == 0);
+            for (int neighbor: roads[city]) {
+                result += (coverCount[neighbor] == 0);
+            }
+            return result;
+        }
+
+        void cover(int city, int delta) {
+            coverCount[city] += delta;
+            for (int neighbor: roads[city]) {
+                coverCount[neighbor] += delta;
+            }
+        }
+
+        void search() {
+            if (current.size() + 1 > best.size() || work > kExactWorkLimit) return;
+
+            /* Find the uncovered city with the fewest uncovered cities around it. */
+            int target = -1, fewest = 0;
+            for (int city = 0; city < int(roads.size()); city++) {
+                if (coverCount[city] > 0) continue;
+                int options = gainOf(city);
+                if (target == -1 || options < fewest) {
+                    target = city;
+                    fewest = options;
+                }
+            }
+            work += roads.size();
+
+            if (target == -1) {
+                best = current;
+                return;
+            }
+
+            auto tryChoosing = [&](int city) {
+                if (coverCount[city] > 0) return;
+                current.push_back(city);
+                cover(city, +1);
+                search();
+                cover(city, -1);
+                current.pop_back();
+            };
+
+            tryChoosing(target);
+            for (int neighbor: roads[target]) {
+                tryChoosing(neighbor);
+            }
+        }
+    };
+
+    /* Finds a small independent dominating set of a snapshot of the network. */
+    vector<int> compactPlanFor(const Roads& roads) {
+        IndependentCover solver(roads);
+        vector<int> result = solver.greedy();
+        if (int(roads.size()) <= kMaxExactCompactionCities) {
+            result = solver.improve(result);
+        }
+        return result;
+    }
+}
+
+OnlineDisasterPlanner::OnlineDisasterPlanner(bool compactInBackground) {
+    if (compactInBackground) {
+        compactor = thread([this] {
+            this->compactInBackground();
+        });
+    }
+}
+
+OnlineDisasterPlanner::~OnlineDisasterPlanner() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCompactor.notify_all();
+    if (compactor.joinable()) compactor.join();
+}
+
+void OnlineDisasterPlanner::addCity(const string& city, const Set<string>& cityRoads) {
+    lock_guard<std::mutex> lock(mutex);
+    if (ids.count(city)) {
+        error("City " + city + " has already arrived.");
+    }
+
+    /* Look everything up before changing anything, so a bad road leaves things as they
+     * were.
+     */
+    vector<int> neighbors;
+    for (const string& neighbor: cityRoads) {
+        auto itr = ids.find(neighbor);
+        if (itr == ids.end()) {
+            error("Road from " + city + " leads to " + neighbor + ", which hasn't arrived.");
+        }
+        neighbors.push_back(itr->second);
+    }
+
+    int id = names.size();
+    ids[city] = id;
+    names.push_back(city);
+    supplied.push_back(false);
+    for (int neighbor: neighbors) {
+        roads[neighbor].push_back(id);
+        largestDegree = max(largestDegree, int(roads[neighbor].size()));
+    }
+    roads.push_back(neighbors);
+    largestDegree = max(largestDegree, int(neighbors.size()));
+
+    placeIfUncovered(id);
+
+    /* Ask for compaction once enough has changed. */
+    arrivalsSinceCompaction++;
+    if (compactor.joinable() &&
+        arrivalsSinceCompaction >= max(kMinCompactionInterval, int(names.size()) / 4)) {
+        arrivalsSinceCompaction = 0;
+        compactionWanted = true;
+        wakeCompactor.notify_one();
+    }
+}
+
+void OnlineDisasterPlanner::placeIfUncovered(int city) {
+    if (!isCovered(roads, supplied, city)) {
+        supplied[city] = true;
+        numSupplied++;
+    }
+}
+
+Set<string> OnlineDisasterPlanner::supplyLocations() const {
+    lock_guard<std::mutex> lock(mutex);
+    Set<string> result;
+    for (int city = 0; city < int(names.size()); city++) {
+        if (supplied[city]) result += names[city];
+    }
+    return result;
+}
+
+int OnlineDisasterPlanner::numSupplyLocations() const {
+    lock_guard<std::mutex> lock(mutex);
+    return numSupplied;
+}
+
+int OnlineDisasterPlanner::numCities() const {
+    lock_guard<std::mutex> lock(mutex);
+    return names.size();
+}
+
+int OnlineDisasterPlanner::maxDegree() const {
+    lock_guard<std::mutex> lock(mutex);
+    return largestDegree;
+}
+
+bool OnlineDisasterPlanner::compact() {
+    TRACE_SCOPE("compact");
+    lock_guard<std::mutex> compactionLock(compactionMutex);
+
+    /* Copy over the roads that cities arrived with since the last compaction. That's
+     * all that's done while holding the lock, so an arrival never waits longer than
+     * it took those cities to arrive. Roads a city arrived with are at the front of
+     * its list, and they're the ones to cities that arrived before it.
+     */
+    int snapshotSize;
+    vector<pair<int, int>> newRoads;
+    {
+        lock_guard<std::mutex> lock(mutex);
+        snapshotSize = names.size();
+        for (int city = mirror.size(); city < snapshotSize; city++) {
+            for (int neighbor: roads[city]) {
+                if (neighbor > city) break;
+                newRoads.push_back({ city, neighbor });
+            }
+        }
+    }
+
+    mirror.resize(snapshotSize);
+    for (const auto& road: newRoads) {
+        mirror[road.first].push_back(road.second);
+        mirror[road.second].push_back(road.first);
+    }
+
+    vector<int> plan = compactPlanFor(mirror);
+    vector<char> candidate(snapshotSize, false);
+    for (int city: plan) {
+        candidate[city] = true;
+    }
+    int size = plan.size();
+
+    lock_guard<std::mutex> lock(mutex);
+
+    /* Replay cities that arrived while we were working through the arrival rule. Each
+     * of them only gets supplies if nothing near it has them, so the plan stays
+     * independent.
+     */
+    candidate.resize(names.size(), false);
+    for (int city = snapshotSize; city < int(names.size()); city++) {
+        if (!isCovered(roads, candidate, city)) {
+            candidate[city] = true;
+            size++;
+        }
+    }
+
+    if (size >= numSupplied) return false;
+    supplied.swap(candidate);
+    numSupplied = size;
+    return true;
+}
+
+void OnlineDisasterPlanner::waitForCompaction() {
+    unique_lock<std::mutex> lock(mutex);
+    compactionDone.wait(lock, [&] {
+        return !compactionWanted && !compacting;
+    });
+}
+
+void OnlineDisasterPlanner::compactInBackground() {
+    TRACE_THREAD_NAME("Compactor");
+
+    unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeCompactor.wait(lock, [&] {
+            return compactionWanted || stopping;
+        });
+        if (stopping) break;
+
+        compactionWanted = false;
+        compacting = true;
+        lock.unlock();
+
+        compact();
+
+        lock.lock();
+        compacting = false;
+        compactionDone.notify_all();
+    }
+
+    compactionWanted = false;
+    compactionDone.notify_all();
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include "map.h"
+
+namespace {
+    /* Checks that the planner's plan covers everything and is independent. */
+    bool isValidPlan(const Map<string, Set<string>>& network, const Set<string>& plan) {
+        for (const string& city: network) {
+            if (!plan.contains(city) && (plan * network[city]).isEmpty()) return false;
+            if (plan.contains(city) && !(plan * network[city]).isEmpty()) return false;
+        }
+        return true;
+    }
+}
+
+STUDENT_TEST("Online planner keeps a valid plan as cities arrive.") {
+    OnlineDisasterPlanner planner(false);
+    Map<string, Set<string>> network;
+
+    /* A path, arriving from one end. */
+    for (int i = 0; i < 20; i++) {
+        string city = "City " + to_string(i);
+        Set<string> cityRoads;
+        if (i > 0) cityRoads += "City " + to_string(i - 1);
+
+        planner.addCity(city, cityRoads);
+        network[city] = cityRoads;
+        for (const string& neighbor: cityRoads) {
+            network[neighbor] += city;
+        }
+
+        EXPECT(isValidPlan(network, planner.supplyLocations()));
+        EXPECT_EQUAL(planner.numSupplyLocations(), planner.supplyLocations().size());
+    }
+    EXPECT_EQUAL(planner.numCities(), 20);
+    EXPECT_EQUAL(planner.maxDegree(), 2);
+
+    /* A path of 20 needs 7 cities; the bound says we use at most twice that. */
+    EXPECT(planner.numSupplyLocations() <= 2 * 7);
+
+    EXPECT_ERROR(planner.addCity("City 0", {}));
+    EXPECT_ERROR(planner.addCity("Elsewhere", { "Nowhere" }));
+    EXPECT_EQUAL(planner.numCities(), 20);
+}
+
+STUDENT_TEST("Compaction recovers from a hub arriving last.") {
+    OnlineDisasterPlanner planner(false);
+    Set<string> spokes;
+    for (int i = 0; i < 10; i++) {
+        string city = "Spoke " + to_string(i);
+        planner.addCity(city, {});
+        spokes += city;
+    }
+    planner.addCity("Hub", spokes);
+    EXPECT_EQUAL(planner.numSupplyLocations(), 10);
+
+    EXPECT(planner.compact());
+    EXPECT_EQUAL(planner.supplyLocations(), { "Hub" });
+    EXPECT(!planner.compact());
+
+    /* Compaction only copies what's new each time, including roads from new cities to
+     * old ones.
+     */
+    Set<string> leaves = { "Spoke 0" };
+    for (int i = 0; i < 5; i++) {
+        string city = "Leaf " + to_string(i);
+        planner.addCity(city, {});
+        leaves += city;
+    }
+    planner.addCity("Second Hub", leaves);
+    EXPECT_EQUAL(planner.numSupplyLocations(), 6);
+
+    EXPECT(planner.compact());
+    EXPECT_EQUAL(planner.supplyLocations(), { "Hub", "Second Hub" });
+}
+
+STUDENT_TEST("Online planner compacts in the background.") {
+    const int kNumCities = 20000;
+
+    /* Cities arrive around a series of hubs, each after its spokes. */
+    OnlineDisasterPlanner planner;
+    Map<string, Set<string>> network;
+    Set<string> spokes;
+    for (int i = 0; i < kNumCities; i++) {
+        string city = "City " + to_string(i);
+        Set<string> cityRoads;
+        if (i % 10 == 9) {
+            cityRoads = spokes;
+            spokes.clear();
+        } else {
+            spokes += city;
+        }
+
+        planner.addCity(city, cityRoads);
+        network[city] = cityRoads;
+        for (const string& neighbor: cityRoads) {
+            network[neighbor] += city;
+        }
+    }
+
+    planner.waitForCompaction();
+    planner.compact();
+    EXPECT(isValidPlan(network, planner.supplyLocations()));
+    EXPECT_EQUAL(planner.numSupplyLocations(), kNumCities / 10);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "set.h"
+
+/**
+ * Keeps a valid disaster plan for a road network that grows one city at a time, without
+ * re-solving the whole network on each arrival.
+ * <p>
+ * When a city arrives, it gets supplies if and only if none of the cities it has roads to
+ * already has them. That takes time proportional to the number of roads the city arrives
+ * with, and keeps the cities with supplies an independent dominating set: every city is
+ * covered, and no two supplied cities are joined by a road. Any such set is at most D
+ * times the size of the best possible plan, where D is the largest number of roads at any
+ * one city, since each city in the best plan can cover at most D supplied cities.
+ * <p>
+ * Arrivals alone can leave the plan far from optimal (think of a hub arriving after all
+ * of the cities around it), so every so often the plan is compacted: the network is
+ * re-solved on a snapshot, cities that arrived in the meantime are replayed through the
+ * arrival rule, and the result replaces the current plan if it's smaller. Compacted plans
+ * are independent dominating sets too, so the guarantee above always holds. By default
+ * compaction runs on a background thread.
+ */
+class OnlineDisasterPlanner {
+public:
+    explicit OnlineDisasterPlanner(bool compactInBackground = true);
+    ~OnlineDisasterPlanner();
+
+    /**
+     * Adds a new city, along with roads to cities that have already arrived.
+     *
+     * @throws ErrorException If the city already exists or a road leads to a city that
+     *                        hasn't arrived.
+     */
+    void addCity(const std::string& city, const Set<std::string>& roads);
+
+    /* The cities that currently have supplies. */
+    Set<std::string> supplyLocations() const;
+    int numSupplyLocations() const;
+
+    int numCities() const;
+
+    /* Largest number of roads at any one city, which bounds how far from optimal the
+     * current plan can be.
+     */
+    int maxDegree() const;
+
+    /**
+     * Compacts the plan right now, on the calling thread.
+     *
+     * @return Whether that made the plan smaller.
+     */
+    bool compact();
+
+    /* Waits until any background compaction that's been asked for has finished. */
+    void waitForCompaction();
+
+    OnlineDisasterPlanner(const OnlineDisasterPlanner&) = delete;
+    OnlineDisasterPlanner& operator= (const OnlineDisasterPlanner&) = delete;
+
+private:
+    mutable std::mutex mutex;
+    std::condition_variable wakeCompactor;  // Signaled when compaction is wanted
+    std::condition_variable compactionDone; // Signaled when the compactor goes idle
+
+    std::unordered_map<std::string, int> ids; // City name -> arrival number
+    std::vector<std::string> names;           // Arrival number -> city name
+    std::vector<std::vector<int>> roads;      // Roads at each city, in both directions
+    std::vector<char> supplied;               // Whether each city has supplies
+    int numSupplied = 0;
+    int largestDegree = 0;
+
+    /* Compaction's own copy of the network, as of the last compaction. Each compaction
+     * copies over just the cities that have arrived since. Only one compaction at a
+     * time can use it.
+     */
+    std::mutex compactionMutex;
+    std::vector<std::vector<int>> mirror;
+
+    int arrivalsSinceCompaction = 0;
+    bool compactionWanted = false;
+    bool compacting = false;
+    bool stopping = false;
+    std::thread compactor;
+
+    /* Applies the arrival rule to the given city. Caller must hold the lock. */
+    void placeIfUncovered(int city);
+
+    /* Body of the background compaction thread. */
+    void compactInBackground();
+};
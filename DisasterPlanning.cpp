@@ -1,4 +1,8 @@
 #include "DisasterPlanning.h"
+#include "DisasterSolvers.h"
+#include "DisasterGrid.h"
+#include "DisasterTrace.h"
+#include "vector.h"
 using namespace std;
 bool isCovered(const string& city,
                const Map<string, Set<string>>& roadNetwork,
@@ -11,28 +15,33 @@ bool canBeMadeDisasterReady(const Map<string, Set<string>>& roadNetwork,
                             Vector<string>& cities,
                             int numCities,
                             int index,
-                            Set<string>& supplyLocations) {
+                            Set<string>& supplyLocations,
+                            SearchStats* stats) {
+    STATS_RECORD(stats, visitNode(index));
     if (supplyLocations.size() > numCities) {
+        STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
         return false;
     }
     if (index == cities.size()) {
         // Check if all cities are covered
         for (string city : cities) {
             if (!isCovered(city, roadNetwork, supplyLocations)) {
+                STATS_RECORD(stats, prune(PruneReason::UNCOVERED_CITY));
                 return false;
             }
         }
         return true;
     }
+    STATS_RECORD(stats, branch(2));
 
     // Choice 1: Don't put a supply in this city
-    if (canBeMadeDisasterReady(roadNetwork, cities, numCities, index + 1, supplyLocations)) {
+    if (canBeMadeDisasterReady(roadNetwork, cities, numCities, index + 1, supplyLocations, stats)) {
         return true;
     }
 
     // Choice 2: Put a supply in this city
     supplyLocations += cities[index];
-    if (canBeMadeDisasterReady(roadNetwork, cities, numCities, index + 1, supplyLocations)) {
+    if (canBeMadeDisasterReady(roadNetwork, cities, numCities, index + 1, supplyLocations, stats)) {
         return true;
     }
     supplyLocations -= cities[index];
@@ -43,17 +52,135 @@ bool canBeMadeDisasterReady(const Map<string, Set<string>>& roadNetwork,
 /*
  * Main function to call backtracking to find a valid supply placement.
  */
-Optional<Set<string>> placeEmergencySupplies(const Map<string, Set<string>>& roadNetwork,
-                                             int numCities) {
+Optional<Set<string>> placeEmergencySuppliesRecursively(const Map<string, Set<string>>& roadNetwork,
+                                                        int numCities,
+                                                        SearchStats* stats) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    TRACE_SCOPE_VALUE("placeEmergencySupplies", "numCities", numCities);
+
+    STATS_RECORD(stats, preprocessing.start());
     Set<string> result;
     Vector<string> cities = roadNetwork.keys();
+    STATS_RECORD(stats, preprocessing.stop());
+
+    bool found;
+    {
+        TRACE_SCOPE("search");
+        STATS_RECORD(stats, search.start());
+        found = canBeMadeDisasterReady(roadNetwork, cities, numCities, 0, result, stats);
+        STATS_RECORD(stats, search.stop());
+    }
+
+    if (!found) {
+        return Nothing;
+    }
+
+    STATS_RECORD(stats, reconstruction.start());
+    Optional<Set<string>> answer = result;
+    STATS_RECORD(stats, reconstruction.stop());
+    return answer;
+}
+
+/*
+ * Grid-shaped networks go to the grid solver, which is exponentially faster on them than
+ * backtracking. Everything else gets the backtracker. The network is converted to its
+ * compact form just once, and the grid solver works out the layout from that.
+ */
+Optional<Set<string>> placeEmergencySupplies(const Map<string, Set<string>>& roadNetwork,
+                                             int numCities,
+                                             SearchStats* stats) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+
+    STATS_RECORD(stats, preprocessing.start());
+    DisasterGraph graph = toGraph(roadNetwork);
+    STATS_RECORD(stats, preprocessing.stop());
+
+    vector<int> chosen;
+    STATS_RECORD(stats, search.start());
+    GridOutcome outcome = solveIfGrid(graph, numCities, chosen, stats);
+    STATS_RECORD(stats, search.stop());
+
+    switch (outcome) {
+        case GridOutcome::SOLVED:      return namesOf(graph, chosen);
+        case GridOutcome::NO_SOLUTION: return Nothing;
+        default: return placeEmergencySuppliesRecursively(roadNetwork, numCities, stats);
+    }
+}
 
-    if (canBeMadeDisasterReady(roadNetwork, cities, numCities, 0, result)) {
-        return result;
+
+/* * * * * * Test Helper Functions Below This Point * * * * * */
+#include "GUI/SimpleTest.h"
+
+/* This is a helper function that's useful for designing test cases. You give it a Map
+ * of cities and what they're adjacent to, and it then produces a new Map where if city
+ * A links to city B, then city B links back to city A.
+ */
+Map<string, Set<string>> makeSymmetric(const Map<string, Set<string>>& source) {
+    Map<string, Set<string>> result = source;
+
+    for (const string& from: source) {
+        for (const string& to: source[from]) {
+            result[from] += to;
+            result[to] += from;
+        }
     }
 
-    return Nothing;
+    return result;
+}
+
+/* This helper function tests whether a city has been covered by a set of supply locations
+ * and is used by our testing code.
+ */
+bool isCovered(const string& city,
+               const Map<string, Set<string>>& roadNetwork,
+               const Set<string>& supplyLocations) {
+    if (supplyLocations.contains(city)) return true;
+
+    for (string neighbor: roadNetwork[city]) {
+        if (supplyLocations.contains(neighbor)) return true;
+    }
+
+    return false;
+}
+
+
+/* * * * * Test Cases Below This Point * * * * */
+
+STUDENT_TEST("Passing in a statistics object doesn't change the answer.") {
+    Map<string, Set<string>> map = makeSymmetric({
+        { "A", { "B" } },
+        { "B", { "C" } },
+        { "C", { "D" } }
+    });
+
+    SearchStats stats;
+    EXPECT_EQUAL(placeEmergencySupplies(map, 1, &stats), Nothing);
+    EXPECT_EQUAL(placeEmergencySupplies(map, 2, &stats), placeEmergencySupplies(map, 2));
+}
+
+#ifdef DISASTER_ENABLE_STATS
+STUDENT_TEST("Search statistics count nodes, prunes, and depth.") {
+    Map<string, Set<string>> map = makeSymmetric({
+        { "A", { } },
+        { "B", { } }
+    });
+
+    /* With no supplies allowed, we walk down the all-excluded path, fail at the
+     * bottom, then get pruned at each of the two "include" branches.
+     */
+    SearchStats stats;
+    EXPECT_EQUAL(placeEmergencySupplies(map, 0, &stats), Nothing);
+    EXPECT_EQUAL(stats.nodesVisited, 5);
+    EXPECT_EQUAL(stats.maxDepth, 2);
+    EXPECT_EQUAL(stats.prunes[int(PruneReason::OVER_BUDGET)], 2);
+    EXPECT_EQUAL(stats.prunes[int(PruneReason::UNCOVERED_CITY)], 1);
+    EXPECT_EQUAL(stats.branchingFactors[2], 2);
 }
+#endif
 
 /* * * * * Provided Tests Below This Point * * * * */
 
@@ -322,19 +449,19 @@ const Map<string, Set<string>> kDontBeGreedy = makeSymmetric({
                                                               { "F", { "G" } },
                                                               });
 
-PROVIDED_TEST("Solves \"Don't be Greedy\" from the handout."); {
+PROVIDED_TEST("Solves \"Don't be Greedy\" from the handout.") {
     EXPECT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 0), Nothing);
     EXPECT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 1), Nothing);
     EXPECT_NOT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 2), Nothing);
 }
 
-PROVIDED_TEST("Solves \"Don't be Greedy\" from the handout, and produces output."); {
+PROVIDED_TEST("Solves \"Don't be Greedy\" from the handout, and produces output.") {
     EXPECT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 0), Nothing);
     EXPECT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 1), Nothing);
     EXPECT_EQUAL(placeEmergencySupplies(kDontBeGreedy, 2), {"B", "F"});
 }
 
-PROVIDED_TEST("Solves \"Don't be Greedy,\" regardless of ordering, and produces output."); {
+PROVIDED_TEST("Solves \"Don't be Greedy,\" regardless of ordering, and produces output.") {
     /* Because Map and Set internally store items in sorted order, the order
      * in which you iterate over the cities when making decisions is sensitive
      * to the order of those cities' names. This test looks at a map like
@@ -368,7 +495,7 @@ PROVIDED_TEST("Solves \"Don't be Greedy,\" regardless of ordering, and produces
     } while (next_permutation(cities.begin(), cities.end()));
 }
 
-PROVIDED_TEST("Stress test: 6 x 6 grid."); {
+PROVIDED_TEST("Stress test: 6 x 6 grid.") {
     Map<string, Set<string>> grid;
 
     /* Build the grid. */
@@ -393,7 +520,7 @@ PROVIDED_TEST("Stress test: 6 x 6 grid."); {
                         );
 }
 
-PROVIDED_TEST("Stress test: 6 x 6 grid, with output."); {
+PROVIDED_TEST("Stress test: 6 x 6 grid, with output.") {
     Optional<Set<string>> locations;
     char maxRow = 'F';
     int  maxCol = 6;
@@ -4,6 +4,7 @@
 #include "set.h"
 #include "map.h"
 #include "Demos/optional.h"
+#include "DisasterStats.h"
 
 /**
  * Given a transportation grid for a country or region, along with the number of cities where disaster
@@ -17,13 +18,21 @@
  * <p>
  * The number of cities can be zero, but it should never be negative. If it is negative, you
  * should report an error by calling the error() function.
+ * <p>
+ * Networks shaped like grids are handed off to a dedicated grid solver (see DisasterGrid.h);
+ * everything else is solved by recursive backtracking.
+ * <p>
+ * When the budget is too small to cover every city, maximizeCoverage (see DisasterCoverage.h)
+ * gives a best-effort plan covering as many cities as possible.
  *
  * @param roadNetwork     The underlying transportation network.
  * @param numCities       How many cities you can afford to put supplies in.
- * @param supplyLocations An outparameter filled in with which cities to choose if a solution exists.
- * @return Whether a solution exists.
+ * @param stats           If non-null, filled in with statistics about the search. This is
+ *                        only populated in builds with DISASTER_ENABLE_STATS defined.
+ * @return Which cities to choose if a solution exists, and Nothing otherwise.
  */
 Optional<Set<std::string>>
 placeEmergencySupplies(const Map<std::string, Set<std::string>>& roadNetwork,
-                       int numCities);
+                       int numCities,
+                       SearchStats* stats = nullptr);
 
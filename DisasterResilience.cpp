@@ -0,0 +1,294 @@
+#include "DisasterResilience.h"
+#include "DisasterSolvers.h"
+#include "DisasterTrace.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+using namespace std;
+
+namespace {
+    /* Fewest cities that cover a graph, counting up from a number known not to be too
+     * many, along with a plan of that size.
+     */
+    int fewestFrom(const DisasterGraph& graph, int lowerBound, vector<int>& plan) {
+        int numCities = lowerBound;
+        while (!dancingLinksSearch(graph, numCities, plan)) {
+            numCities++;
+        }
+        return numCities;
+    }
+
+    /* A copy of the graph with only the roads for which keep(from, to) is true. */
+    template <typename Keep> DisasterGraph filtered(const DisasterGraph& graph, Keep keep) {
+        DisasterGraph result;
+        result.names = graph.names;
+        result.offsets.reserve(graph.offsets.size());
+        result.neighbors.reserve(graph.neighbors.size());
+
+        result.offsets.push_back(0);
+        for (int city = 0; city < graph.numCities(); city++) {
+            for (int neighbor: graph.neighborsOf(city)) {
+                if (keep(city, neighbor)) result.neighbors.push_back(neighbor);
+            }
+            result.offsets.push_back(int(result.neighbors.size()));
+        }
+        return result;
+    }
+
+    /* Whether the chosen cities cover every city in the graph other than the one
+     * given, which may be -1 to check every city.
+     */
+    bool coversAllBut(const DisasterGraph& graph, const vector<char>& chosen, int skip) {
+        for (int city = 0; city < graph.numCities(); city++) {
+            if (city == skip || chosen[city]) continue;
+
+            bool covered = false;
+            for (int neighbor: graph.neighborsOf(city)) {
+                if (chosen[neighbor]) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (!covered) return false;
+        }
+        return true;
+    }
+
+    /* Everything the scenarios share. */
+    struct Baseline {
+        const DisasterGraph& graph;
+        int fewest;
+        vector<char> inPlan;  // Whether each city is in an optimal plan
+    };
+
+    /* Fewest cities needed once the road between from and to is lost. */
+    int withoutRoad(const Baseline& baseline, int from, int to) {
+        TRACE_SCOPE("road");
+        DisasterGraph graph = filtered(baseline.graph, [&](int one, int two) {
+            return !((one == from && two == to) || (one == to && two == from));
+        });
+
+        if (coversAllBut(graph, baseline.inPlan, -1)) return baseline.fewest;
+
+        vector<int> plan;
+        return fewestFrom(graph, baseline.fewest, plan);
+    }
+
+    /* Fewest cities needed once the given city is lost. Rather than renumbering the
+     * cities, this cuts the lost city's roads. Any plan for the result has to give the
+     * city supplies of its own, and otherwise is a plan for the network without it.
+     */
+    int withoutCity(const Baseline& baseline, int lost) {
+        TRACE_SCOPE("city");
+        DisasterGraph graph = filtered(baseline.graph, [&](int one, int two) {
+            return one != lost && two != lost;
+        });
+
+        vector<int> plan;
+        if (!baseline.inPlan[lost]) {
+            /* The baseline plan still works, so the only question is whether one fewer
+             * city would do.
+             */
+            return dancingLinksSearch(graph, baseline.fewest, plan)? baseline.fewest - 1
+                                                                   : baseline.fewest;
+        }
+        if (coversAllBut(graph, baseline.inPlan, lost)) return baseline.fewest - 1;
+        return fewestFrom(graph, baseline.fewest, plan) - 1;
+    }
+
+    /* Runs job(i) for each i in [0, count) across the given number of threads, one of
+     * which is the calling thread. Only the threads started here are renamed in traces.
+     */
+    template <typename Job> void runInParallel(int count, int numThreads, Job job) {
+        atomic<int> next(0);
+        auto work = [&] {
+            for (int i = next++; i < count; i = next++) {
+                job(i);
+            }
+        };
+
+        vector<thread> threads;
+        for (int i = 1; i < min(numThreads, count); i++) {
+            threads.emplace_back([&] {
+                TRACE_THREAD_NAME("Resilience");
+                work();
+            });
+        }
+        work();
+        for (thread& worker: threads) {
+            worker.join();
+        }
+    }
+}
+
+ResilienceReport analyzeResilience(const Map<string, Set<string>>& roadNetwork,
+                                   int numThreads) {
+    TRACE_SCOPE("analyzeResilience");
+    if (numThreads <= 0) {
+        numThreads = max(1u, thread::hardware_concurrency());
+    }
+
+    DisasterGraph graph = toGraph(roadNetwork);
+    int n = graph.numCities();
+
+    /* Every city covers at most itself and its neighbors. */
+    int maxDegree = 0;
+    for (int city = 0; city < n; city++) {
+        maxDegree = max(maxDegree, graph.degree(city));
+    }
+
+    vector<int> plan;
+    Baseline baseline = { graph, fewestFrom(graph, (n + maxDegree) / (maxDegree + 1), plan), {} };
+    baseline.inPlan.assign(n, false);
+    for (int city: plan) {
+        baseline.inPlan[city] = true;
+    }
+
+    /* Each road once, from the endpoint that comes first alphabetically. */
+    vector<pair<int, int>> roads;
+    for (int city = 0; city < n; city++) {
+        for (int neighbor: graph.neighborsOf(city)) {
+            if (city < neighbor) roads.push_back({ city, neighbor });
+        }
+    }
+
+    int numRoads = roads.size();
+    vector<int> depotsNeeded(numRoads + n);
+    runInParallel(numRoads + n, numThreads, [&](int scenario) {
+        depotsNeeded[scenario] = scenario < numRoads
+                               ? withoutRoad(baseline, roads[scenario].first, roads[scenario].second)
+                               : withoutCity(baseline, scenario - numRoads);
+    });
+
+    /* Assemble the tables, most critical first. */
+    vector<RoadFailure> roadRows;
+    for (int i = 0; i < numRoads; i++) {
+        roadRows.push_back({ graph.names[roads[i].first], graph.names[roads[i].second],
+                             depotsNeeded[i], depotsNeeded[i] - baseline.fewest });
+    }
+    stable_sort(roadRows.begin(), roadRows.end(), [](const RoadFailure& lhs, const RoadFailure& rhs) {
+        return lhs.criticality > rhs.criticality;
+    });
+
+    vector<CityFailure> cityRows;
+    for (int city = 0; city < n; city++) {
+        int needed = depotsNeeded[numRoads + city];
+        cityRows.push_back({ graph.names[city], needed, needed - baseline.fewest });
+    }
+    stable_sort(cityRows.begin(), cityRows.end(), [](const CityFailure& lhs, const CityFailure& rhs) {
+        return lhs.criticality > rhs.criticality;
+    });
+
+    ResilienceReport result;
+    result.baseline = baseline.fewest;
+    result.plan = namesOf(graph, plan);
+    for (const RoadFailure& row: roadRows) {
+        result.roads += row;
+    }
+    for (const CityFailure& row: cityRows) {
+        result.cities += row;
+    }
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+namespace {
+    /* Fewest cities covering a network, found the slow way. */
+    int fewestFor(const Map<string, Set<string>>& network) {
+        for (int k = 0; ; k++) {
+            if (placeEmergencySupplies(network, k, SolverMode::ITERATIVE) != Nothing) return k;
+        }
+    }
+
+    Map<string, Set<string>> randomNetwork(mt19937_64& engine, int numCities) {
+        Map<string, Set<string>> result;
+        for (int i = 0; i < numCities; i++) {
+            result["City " + to_string(i)];
+        }
+        for (int i = 0; i < numCities; i++) {
+            for (int j = i + 1; j < numCities; j++) {
+                if (engine() % 4 == 0) {
+                    result["City " + to_string(i)] += "City " + to_string(j);
+                    result["City " + to_string(j)] += "City " + to_string(i);
+                }
+            }
+        }
+        return result;
+    }
+}
+
+STUDENT_TEST("Resilience report matches solving each scenario separately.") {
+    mt19937_64 engine(2718);
+    for (int round = 0; round < 25; round++) {
+        auto network = randomNetwork(engine, 1 + engine() % 10);
+        ResilienceReport report = analyzeResilience(network, 1 + round % 3);
+
+        EXPECT_EQUAL(report.baseline, fewestFor(network));
+        EXPECT_EQUAL(report.plan.size(), report.baseline);
+
+        int numRoads = 0;
+        for (const string& city: network) {
+            numRoads += network[city].size();
+        }
+        EXPECT_EQUAL(report.roads.size(), numRoads / 2);
+        EXPECT_EQUAL(report.cities.size(), network.size());
+
+        for (const RoadFailure& road: report.roads) {
+            auto without = network;
+            without[road.from] -= road.to;
+            without[road.to]   -= road.from;
+            EXPECT_EQUAL(road.depotsNeeded, fewestFor(without));
+            EXPECT_EQUAL(road.criticality, road.depotsNeeded - report.baseline);
+        }
+        for (const CityFailure& city: report.cities) {
+            auto without = network;
+            without.remove(city.city);
+            for (const string& other: without) {
+                without[other] -= city.city;
+            }
+            EXPECT_EQUAL(city.depotsNeeded, fewestFor(without));
+            EXPECT_EQUAL(city.criticality, city.depotsNeeded - report.baseline);
+        }
+
+        /* Most critical first. */
+        for (int i = 1; i < report.roads.size(); i++) {
+            EXPECT(report.roads[i - 1].criticality >= report.roads[i].criticality);
+        }
+        for (int i = 1; i < report.cities.size(); i++) {
+            EXPECT(report.cities[i - 1].criticality >= report.cities[i].criticality);
+        }
+    }
+}
+
+STUDENT_TEST("Resilience report for a path.") {
+    /* A - B - C - D - E is covered by B and D. Cutting B - C leaves A - B and C - D - E,
+     * which still only need two; cutting A - B strands A.
+     */
+    Map<string, Set<string>> path = {
+        { "A", { "B" } },
+        { "B", { "A", "C" } },
+        { "C", { "B", "D" } },
+        { "D", { "C", "E" } },
+        { "E", { "D" } },
+    };
+    ResilienceReport report = analyzeResilience(path);
+    EXPECT_EQUAL(report.baseline, 2);
+
+    Map<string, int> byRoad;
+    for (const RoadFailure& road: report.roads) {
+        byRoad[road.from + road.to] = road.depotsNeeded;
+    }
+    EXPECT_EQUAL(byRoad, { { "AB", 3 }, { "BC", 2 }, { "CD", 2 }, { "DE", 3 } });
+
+    /* Losing C splits the path into two pieces needing one city each. */
+    Map<string, int> byCity;
+    for (const CityFailure& city: report.cities) {
+        byCity[city.city] = city.depotsNeeded;
+    }
+    EXPECT_EQUAL(byCity, { { "A", 2 }, { "B", 2 }, { "C", 2 }, { "D", 2 }, { "E", 2 } });
+
+    EXPECT_EQUAL(analyzeResilience({}).baseline, 0);
+}
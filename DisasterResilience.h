@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include "map.h"
+#include "set.h"
+#include "vector.h"
+
+/* What happens to the plan if one road is lost. */
+struct RoadFailure {
+    std::string from;    // The road's endpoints, with from < to
+    std::string to;
+    int depotsNeeded;    // Fewest cities needing supplies without the road
+    int criticality;     // How many more that is than for the intact network
+};
+
+/* What happens to the plan if one city is lost, along with all of its roads. */
+struct CityFailure {
+    std::string city;
+    int depotsNeeded;    // Fewest cities needing supplies for the cities that remain
+    int criticality;     // How many more that is than for the intact network; may be -1
+};
+
+/**
+ * The fewest cities needing supplies for a network, and for that network with each road,
+ * and each city, taken out in turn.
+ */
+struct ResilienceReport {
+    int baseline = 0;            // Fewest cities needing supplies for the intact network
+    Set<std::string> plan;       // A plan of that size
+    Vector<RoadFailure> roads;   // Most critical first, ties in alphabetical order
+    Vector<CityFailure> cities;  // Most critical first, ties in alphabetical order
+};
+
+/**
+ * Works out how losing each road, and each city, would change the fewest cities that
+ * need supplies.
+ * <p>
+ * The network is converted to the compact graph once, and every scenario is cut out of
+ * that. An optimal plan for the intact network bounds each answer, so most scenarios
+ * need at most one search, and some need none:
+ * <ul>
+ *   <li>Losing a road never makes a plan smaller, and adding one of its endpoints to a
+ *       plan makes up for it, so the answer is the baseline or one more. If the
+ *       baseline plan still covers everything, it's the baseline.</li>
+ *   <li>Losing a city never saves more than that one city. If the baseline plan doesn't
+ *       use the city, it still works, so the answer is at most the baseline. If it does,
+ *       and the plan still works without it, the answer is one less.</li>
+ * </ul>
+ * The scenarios are spread across a pool of threads.
+ *
+ * @param roadNetwork The network, with bidirectional roads as in placeEmergencySupplies.
+ * @param numThreads  How many threads to use, or 0 for one per hardware thread.
+ * @return The baseline along with a row for each road and each city.
+ */
+ResilienceReport analyzeResilience(const Map<std::string, Set<std::string>>& roadNetwork,
+                                   int numThreads = 0);
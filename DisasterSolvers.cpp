@@ -0,0 +1,85 @@
+#include "DisasterSolvers.h"
+#include "DisasterGrid.h"
+#include "DisasterTrace.h"
+#include "error.h"
+using namespace std;
+
+namespace {
+    /* Signature shared by all the engines that work on the compact graph. */
+    using GraphSearch = bool (*)(const DisasterGraph&, int, vector<int>&, SearchStats*, const CancelFlag*);
+
+    /* Runs one of the compact graph engines, converting to and from strings. */
+    Optional<Set<string>> solveOnGraph(GraphSearch search,
+                                       const Map<string, Set<string>>& roadNetwork,
+                                       int numCities,
+                                       SearchStats* stats,
+                                       const CancelFlag* cancel) {
+        TRACE_SCOPE_VALUE("placeEmergencySupplies", "numCities", numCities);
+
+        DisasterGraph graph;
+        {
+            TRACE_SCOPE("preprocess");
+            STATS_RECORD(stats, preprocessing.start());
+            graph = toGraph(roadNetwork);
+            STATS_RECORD(stats, preprocessing.stop());
+        }
+
+        vector<int> chosen;
+        bool found;
+        {
+            TRACE_SCOPE("search");
+            STATS_RECORD(stats, search.start());
+            found = search(graph, numCities, chosen, stats, cancel);
+            STATS_RECORD(stats, search.stop());
+        }
+        if (!found) return Nothing;
+
+        STATS_RECORD(stats, reconstruction.start());
+        Optional<Set<string>> result = namesOf(graph, chosen);
+        STATS_RECORD(stats, reconstruction.stop());
+        return result;
+    }
+}
+
+Vector<SolverMode> allSolverModes() {
+    return {
+        SolverMode::RECURSIVE,
+        SolverMode::ITERATIVE,
+        SolverMode::GRID,
+        SolverMode::DANCING_LINKS,
+        SolverMode::BITSET,
+    };
+}
+
+string nameOf(SolverMode mode) {
+    switch (mode) {
+        case SolverMode::RECURSIVE: return "recursive";
+        case SolverMode::ITERATIVE: return "iterative";
+        case SolverMode::GRID:      return "grid";
+        case SolverMode::DANCING_LINKS: return "dancing links";
+        case SolverMode::BITSET:        return "bitset";
+        default: break;
+    }
+    error("Unknown solver mode.");
+    return "";
+}
+
+Optional<Set<string>> placeEmergencySupplies(const Map<string, Set<string>>& roadNetwork,
+                                             int numCities,
+                                             SolverMode mode,
+                                             SearchStats* stats,
+                                             const CancelFlag* cancel) {
+    if (numCities < 0) {
+        error("Number of cities can't be negative.");
+    }
+    switch (mode) {
+        case SolverMode::RECURSIVE: return placeEmergencySuppliesRecursively(roadNetwork, numCities, stats);
+        case SolverMode::ITERATIVE: return solveOnGraph(iterativeSearch, roadNetwork, numCities, stats, cancel);
+        case SolverMode::GRID:      return solveOnGraph(gridSearch, roadNetwork, numCities, stats, cancel);
+        case SolverMode::DANCING_LINKS: return solveOnGraph(dancingLinksSearch, roadNetwork, numCities, stats, cancel);
+        case SolverMode::BITSET:        return solveOnGraph(bitsetSearch, roadNetwork, numCities, stats, cancel);
+        default: break;
+    }
+    error("Unknown solver mode.");
+    return Nothing;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "DisasterPlanning.h"
+#include "DisasterGraph.h"
+#include "vector.h"
+
+/* The different engines that can answer the disaster planning question. They all
+ * agree on whether a solution exists; where noted, they also agree on which
+ * solution they find.
+ */
+enum class SolverMode {
+    RECURSIVE,  // The reference recursive backtracker in DisasterPlanning.cpp.
+    ITERATIVE,  // Same search order as RECURSIVE, with an explicit stack. Same answers.
+    GRID,       // Profile dynamic program for grids; ITERATIVE for anything else.
+    DANCING_LINKS, // Set cover over dancing links. Finds a solution whenever the others do.
+    BITSET,        // Fixed-size bitsets up to 512 cities; DANCING_LINKS for anything larger.
+};
+
+/* A flag that another thread can set to ask a search to give up early. A search that's
+ * been cancelled reports that it found no solution.
+ */
+using CancelFlag = std::atomic<bool>;
+
+/* All available solver modes, in the order they were added. */
+Vector<SolverMode> allSolverModes();
+
+/* Returns a human-readable name for a solver mode. */
+std::string nameOf(SolverMode mode);
+
+/**
+ * Solves the disaster planning problem using the given solver. The arguments and
+ * return value are the same as for the two-argument placeEmergencySupplies. If cancel
+ * is non-null, the search stops and returns Nothing soon after it's set; RECURSIVE
+ * never checks it.
+ */
+Optional<Set<std::string>>
+placeEmergencySupplies(const Map<std::string, Set<std::string>>& roadNetwork,
+                       int numCities,
+                       SolverMode mode,
+                       SearchStats* stats = nullptr,
+                       const CancelFlag* cancel = nullptr);
+
+/**
+ * The reference recursive backtracker, which tries each city with and without supplies
+ * in alphabetical order. This is what SolverMode::RECURSIVE runs.
+ */
+Optional<Set<std::string>>
+placeEmergencySuppliesRecursively(const Map<std::string, Set<std::string>>& roadNetwork,
+                                  int numCities,
+                                  SearchStats* stats = nullptr);
+
+
+/* * * * * Engines working on the compact graph form * * * * */
+
+/* Each of these functions searches the given graph for a way to cover every city using
+ * at most numCities supply locations. If one exists, it returns true and fills in
+ * chosen with the cities to use; otherwise it returns false. They also return false if
+ * cancel is set while they're running.
+ */
+
+/**
+ * Iterative backtracker. Makes exactly the same decisions in the same order as the
+ * recursive solver, so it finds the same answer, but keeps its decisions on an explicit
+ * preallocated stack rather than the call stack. It's therefore safe to use on networks
+ * with hundreds of thousands of cities. It also skips over any branch in which a city
+ * can no longer be covered, which can't change the answer found.
+ */
+bool iterativeSearch(const DisasterGraph& graph, int numCities,
+                     std::vector<int>& chosen, SearchStats* stats = nullptr,
+                     const CancelFlag* cancel = nullptr);
+
+/**
+ * Set cover over dancing links. Each city is a row, listing the cities it would cover,
+ * and a column, listing the cities that could cover it. The search repeatedly takes
+ * the column with the fewest rows left and tries each of those rows. Choosing a row and
+ * ruling one out are just a few link updates each, and are undone the same way, so the
+ * search allocates nothing as it goes.
+ */
+bool dancingLinksSearch(const DisasterGraph& graph, int numCities,
+                        std::vector<int>& chosen, SearchStats* stats = nullptr,
+                        const CancelFlag* cancel = nullptr);
+
+/**
+ * Search over bitsets whose size is fixed at compile time. There are versions for
+ * networks of up to 64, 128, 256 and 512 cities, and the smallest that fits is picked
+ * when the search starts; larger networks go to dancingLinksSearch. Every set operation
+ * runs over a constant number of words, so it compiles down to a handful of
+ * instructions with no loops or heap memory.
+ */
+bool bitsetSearch(const DisasterGraph& graph, int numCities,
+                  std::vector<int>& chosen, SearchStats* stats = nullptr,
+                  const CancelFlag* cancel = nullptr);
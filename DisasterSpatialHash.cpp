@@ -0,0 +1,290 @@
+#include "DisasterSpatialHash.h"
+#include "DisasterGeometry.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tuple>
+using namespace std;
+
+namespace {
+    bool sameLocation(const GPoint& one, const GPoint& two) {
+        return one.x == two.x && one.y == two.y;
+    }
+
+    /* Whether two points are at most the given distance apart. Distance zero is checked
+     * exactly, since squaring the gap between two very close points can round to zero.
+     */
+    bool isWithin(const GPoint& one, const GPoint& two, double distance) {
+        if (distance == 0) return sameLocation(one, two);
+        return squaredDistance(one, two) <= distance * distance;
+    }
+}
+
+SpatialHash::SpatialHash(const vector<GPoint>& points) : points(points) {
+    int n = int(points.size());
+    if (n == 0) {
+        cellStarts = { 0, 0 };
+        return;
+    }
+
+    minX = minY = numeric_limits<double>::infinity();
+    double maxX = -numeric_limits<double>::infinity();
+    double maxY = -numeric_limits<double>::infinity();
+    for (const GPoint& point: points) {
+        minX = min(minX, point.x);
+        minY = min(minY, point.y);
+        maxX = max(maxX, point.x);
+        maxY = max(maxY, point.y);
+    }
+
+    /* Aim for square cells, about one per point. If the points all lie on a line, split
+     * the line instead, and if they're all in one place, any size will do.
+     */
+    double width = maxX - minX, height = maxY - minY;
+    if (width > 0 && height > 0) cellSize = sqrt(width / n * height);
+    else                         cellSize = max(width, height) / n;
+    if (!(cellSize > 0)) cellSize = 1;
+
+    /* Very long, thin boxes would need more cells than that along their length, so use
+     * bigger cells to keep the count down. Coordinates too far apart for the box to have
+     * a size end up with everything in one cell.
+     */
+    if (isfinite(cellSize)) {
+        cellsX = int(min(floor(width  / cellSize) + 1, double(n)));
+        cellsY = int(min(floor(height / cellSize) + 1, double(n)));
+        cellSize = max({ cellSize, width / cellsX, height / cellsY });
+    }
+
+    /* Counting sort of the points by cell. Going through the points in order leaves each
+     * cell's points in increasing order.
+     */
+    vector<int> cells(n);
+    cellStarts.assign(cellsX * cellsY + 1, 0);
+    for (int i = 0; i < n; i++) {
+        cells[i] = rowOf(points[i].y) * cellsX + columnOf(points[i].x);
+        cellStarts[cells[i] + 1]++;
+    }
+    for (int cell = 0; cell < cellsX * cellsY; cell++) {
+        cellStarts[cell + 1] += cellStarts[cell];
+    }
+    members.resize(n);
+    vector<int> next(cellStarts.begin(), cellStarts.end() - 1);
+    for (int i = 0; i < n; i++) {
+        members[next[cells[i]]++] = i;
+    }
+}
+
+/* Which column or row a coordinate falls in. Coordinates off the grid go in the nearest
+ * column or row, which keeps queries centered off the grid working.
+ */
+int SpatialHash::columnOf(double x) const {
+    double column = (x - minX) / cellSize;
+    if (!(column >= 0)) return 0;
+    return int(min(column, double(cellsX - 1)));
+}
+
+int SpatialHash::rowOf(double y) const {
+    double row = (y - minY) / cellSize;
+    if (!(row >= 0)) return 0;
+    return int(min(row, double(cellsY - 1)));
+}
+
+template <typename Function>
+void SpatialHash::forEachIn(int lowColumn, int highColumn, int lowRow, int highRow, Function fn) const {
+    lowColumn = max(lowColumn, 0);
+    lowRow    = max(lowRow, 0);
+    highColumn = min(highColumn, cellsX - 1);
+    highRow    = min(highRow, cellsY - 1);
+
+    for (int row = lowRow; row <= highRow; row++) {
+        for (int column = lowColumn; column <= highColumn; column++) {
+            int cell = row * cellsX + column;
+            for (int member = cellStarts[cell]; member < cellStarts[cell + 1]; member++) {
+                fn(members[member]);
+            }
+        }
+    }
+}
+
+int SpatialHash::nearest(const GPoint& query) const {
+    int best = -1;
+    double bestDistance = 0;
+    auto consider = [&](int index) {
+        double distance = squaredDistance(query, points[index]);
+        if (best == -1 || distance < bestDistance || (distance == bestDistance && index < best)) {
+            best = index;
+            bestDistance = distance;
+        }
+    };
+
+    /* Look at rings of cells around the query's cell, working outward. Everything past
+     * ring r is more than r cells' widths away, so once the best point is closer than
+     * that, nothing further out can beat it. Stopping one ring later than that leaves
+     * room for points that rounding put in the cell next to the one they belong in.
+     */
+    int column = columnOf(query.x), row = rowOf(query.y);
+    int numRings = max(cellsX, cellsY);
+    for (int ring = 0; ring <= numRings; ring++) {
+        if (ring == 0) {
+            forEachIn(column, column, row, row, consider);
+        } else {
+            forEachIn(column - ring, column + ring, row - ring, row - ring, consider);
+            forEachIn(column - ring, column + ring, row + ring, row + ring, consider);
+            forEachIn(column - ring, column - ring, row - ring + 1, row + ring - 1, consider);
+            forEachIn(column + ring, column + ring, row - ring + 1, row + ring - 1, consider);
+        }
+
+        double reach = (ring - 1) * cellSize;
+        if (best != -1 && ring >= 1 && bestDistance < reach * reach) break;
+    }
+    return best;
+}
+
+vector<int> SpatialHash::withinRadius(const GPoint& query, double radius) const {
+    vector<int> result;
+    if (radius < 0) return result;
+
+    forEachIn(columnOf(query.x - radius), columnOf(query.x + radius),
+              rowOf(query.y - radius), rowOf(query.y + radius), [&](int index) {
+        if (isWithin(query, points[index], radius)) result.push_back(index);
+    });
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<pair<int, int>> SpatialHash::pairsWithin(double distance) const {
+    vector<pair<int, int>> result;
+    if (distance < 0) return result;
+
+    /* How many cells over a partner can be. */
+    double cells = ceil(distance / cellSize);
+    int span = cells < max(cellsX, cellsY)? int(cells) : max(cellsX, cellsY);
+    for (int i = 0; i < size(); i++) {
+        int column = columnOf(points[i].x), row = rowOf(points[i].y);
+        forEachIn(column - span, column + span, row - span, row + span, [&](int j) {
+            if (j > i && isWithin(points[i], points[j], distance)) result.emplace_back(i, j);
+        });
+    }
+    sort(result.begin(), result.end());
+    return result;
+}
+
+vector<int> SpatialHash::firstAtSameLocation() const {
+    vector<int> result(points.size());
+
+    /* Points at the same location always share a cell, so sort each cell's points by
+     * location and read off the runs of equal ones. Sorting instead of comparing every
+     * pair keeps this quick even when many points pile up in one place.
+     */
+    vector<int> cell;
+    for (int index = 0; index + 1 < int(cellStarts.size()); index++) {
+        cell.assign(members.begin() + cellStarts[index], members.begin() + cellStarts[index + 1]);
+        sort(cell.begin(), cell.end(), [&](int lhs, int rhs) {
+            return make_tuple(points[lhs].x, points[lhs].y, lhs) < make_tuple(points[rhs].x, points[rhs].y, rhs);
+        });
+
+        for (size_t i = 0; i < cell.size(); i++) {
+            bool startsRun = i == 0 || !sameLocation(points[cell[i]], points[cell[i - 1]]);
+            result[cell[i]] = startsRun? cell[i] : result[cell[i - 1]];
+        }
+    }
+    return result;
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <random>
+
+STUDENT_TEST("Spatial hash queries match checking every point.") {
+    mt19937_64 engine(137);
+    for (int round = 0; round < 20; round++) {
+        /* Integer coordinates on a small grid, so there are plenty of ties and points
+         * in the same place. Some rounds squash the grid flat.
+         */
+        vector<GPoint> points;
+        int n = engine() % 200;
+        int height = round % 4 == 0? 1 : 30;
+        for (int i = 0; i < n; i++) {
+            points.push_back(GPoint(engine() % 30, engine() % height));
+        }
+        SpatialHash hash(points);
+        EXPECT_EQUAL(hash.size(), n);
+
+        for (int query = 0; query < 50; query++) {
+            GPoint point((engine() % 400) / 10.0 - 5, (engine() % 400) / 10.0 - 5);
+            double radius = (engine() % 100) / 10.0;
+
+            int closest = -1;
+            vector<int> within;
+            for (int i = 0; i < n; i++) {
+                double distance = squaredDistance(point, points[i]);
+                if (closest == -1 || distance < squaredDistance(point, points[closest])) closest = i;
+                if (distance <= radius * radius) within.push_back(i);
+            }
+            EXPECT_EQUAL(hash.nearest(point), closest);
+            EXPECT(hash.withinRadius(point, radius) == within);
+        }
+
+        for (double distance: { 0.0, 1.0, 1.5 }) {
+            vector<pair<int, int>> pairs;
+            for (int i = 0; i < n; i++) {
+                for (int j = i + 1; j < n; j++) {
+                    if (isWithin(points[i], points[j], distance)) pairs.emplace_back(i, j);
+                }
+            }
+            EXPECT(hash.pairsWithin(distance) == pairs);
+        }
+
+        vector<int> first(n);
+        for (int i = 0; i < n; i++) {
+            first[i] = i;
+            for (int j = 0; j < i; j++) {
+                if (sameLocation(points[j], points[i])) {
+                    first[i] = j;
+                    break;
+                }
+            }
+        }
+        EXPECT(hash.firstAtSameLocation() == first);
+    }
+}
+
+STUDENT_TEST("Spatial hash handles points all in one place and far-flung points.") {
+    EXPECT_EQUAL(SpatialHash().nearest({ 0, 0 }), -1);
+    EXPECT(SpatialHash().withinRadius({ 0, 0 }, 10).empty());
+
+    /* Everything at one spot, including a negative zero. */
+    SpatialHash pile({ { 1, 0 }, { 1, -0.0 }, { 1, 0 } });
+    EXPECT_EQUAL(pile.nearest({ 50, 50 }), 0);
+    EXPECT(pile.firstAtSameLocation() == vector<int>({ 0, 0, 0 }));
+    EXPECT_EQUAL(pile.pairsWithin(0).size(), 3);
+
+    /* Points so far apart the box around them has no finite size, and points so close
+     * that the square of the gap between them rounds to zero.
+     */
+    SpatialHash far({ { -1e308, 0 }, { 1e308, 0 }, { 0, 1e-200 }, { 0, 0 } });
+    EXPECT_EQUAL(far.nearest({ 1e308, 0 }), 1);
+    EXPECT_EQUAL(far.nearest({ 0, 1 }), 2);
+    EXPECT(far.withinRadius({ 0, 0 }, 0) == vector<int>({ 3 }));
+    EXPECT(far.pairsWithin(0).empty());
+    EXPECT(far.firstAtSameLocation() == vector<int>({ 0, 1, 2, 3 }));
+}
+
+STUDENT_TEST("Spatial hash finds nearby points quickly.") {
+    mt19937_64 engine(0);
+    uniform_real_distribution<double> coordinate(0, 1000);
+
+    vector<GPoint> points;
+    for (int i = 0; i < 200000; i++) {
+        points.push_back(GPoint(coordinate(engine), coordinate(engine)));
+    }
+
+    EXPECT_COMPLETES_IN(5.0, {
+        SpatialHash hash(points);
+        for (int i = 0; i < 200000; i++) {
+            hash.nearest(GPoint(coordinate(engine), coordinate(engine)));
+        }
+        hash.pairsWithin(0.01);
+        hash.firstAtSameLocation();
+    });
+}
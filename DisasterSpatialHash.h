@@ -0,0 +1,63 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+#include "gtypes.h"
+
+/**
+ * A uniform grid over a fixed set of points, for finding points that are close to one
+ * another or to a query point by looking only at nearby cells. Points are referred to by
+ * their index in the vector the grid was built from.
+ * <p>
+ * The grid covers the bounding box of the points with about one cell per point, so for
+ * points spread over a map the way cities are, each query looks at a handful of points.
+ * Cells are stored back to back in one array, with each cell's points listed together,
+ * so building the grid is a counting sort and nothing is allocated per cell.
+ */
+class SpatialHash {
+public:
+    explicit SpatialHash(const std::vector<GPoint>& points = {});
+
+    /* Index of the point closest to the query point, or -1 if there are no points. Ties
+     * go to the lowest index.
+     */
+    int nearest(const GPoint& query) const;
+
+    /* Indices of all points at distance at most radius from the query point, in
+     * increasing order. A radius of zero finds the points at exactly that location.
+     */
+    std::vector<int> withinRadius(const GPoint& query, double radius) const;
+
+    /* All pairs of points, as (lower index, higher index), at distance at most the one
+     * given from each other, in increasing order. This is meant for spotting points that
+     * are nearly on top of one another, so the distance should be small next to the
+     * spacing of the points.
+     */
+    std::vector<std::pair<int, int>> pairsWithin(double distance) const;
+
+    /* For each point, the lowest index of a point at exactly the same location, which is
+     * the point's own index if nothing else is there.
+     */
+    std::vector<int> firstAtSameLocation() const;
+
+    int size() const {
+        return int(points.size());
+    }
+
+private:
+    std::vector<GPoint> points;
+
+    double minX = 0, minY = 0;
+    double cellSize = 1;
+    int cellsX = 1, cellsY = 1;
+
+    std::vector<int> cellStarts;  // Where each cell's points begin in members
+    std::vector<int> members;     // Point indices, grouped by cell, in increasing order within each
+
+    int columnOf(double x) const;
+    int rowOf(double y) const;
+
+    /* Calls fn on each point in the cells in the given block, clipped to the grid. */
+    template <typename Function>
+    void forEachIn(int lowColumn, int highColumn, int lowRow, int highRow, Function fn) const;
+};
@@ -0,0 +1,54 @@
+#include "DisasterStats.h"
+#include "error.h"
+#include <algorithm>
+using namespace std;
+
+string nameOf(PruneReason reason) {
+    switch (reason) {
+        case PruneReason::OVER_BUDGET:      return "over budget";
+        case PruneReason::UNCOVERED_CITY:   return "uncovered city";
+        case PruneReason::UNCOVERABLE_CITY: return "uncoverable city";
+        case PruneReason::NO_IMPROVEMENT:   return "no improvement";
+        default: break;
+    }
+    error("Unknown prune reason.");
+    return "";
+}
+
+void SearchStats::visitNode(int depth) {
+    nodesVisited++;
+    maxDepth = max(maxDepth, depth);
+}
+
+void SearchStats::prune(PruneReason reason) {
+    prunes[int(reason)]++;
+}
+
+void SearchStats::branch(int numOptions) {
+    branchingFactors[numOptions]++;
+}
+
+long long SearchStats::totalPrunes() const {
+    long long result = 0;
+    for (long long count: prunes) {
+        result += count;
+    }
+    return result;
+}
+
+ostream& operator<< (ostream& out, const SearchStats& stats) {
+    out << "Nodes visited:  " << stats.nodesVisited << endl;
+    out << "Maximum depth:  " << stats.maxDepth << endl;
+    out << "Prunes:         " << stats.totalPrunes() << endl;
+    for (int i = 0; i < int(PruneReason::NUM_REASONS); i++) {
+        out << "  " << nameOf(PruneReason(i)) << ": " << stats.prunes[i] << endl;
+    }
+    out << "Branching factors:" << endl;
+    for (int options: stats.branchingFactors) {
+        out << "  " << options << " options: " << stats.branchingFactors[options] << " nodes" << endl;
+    }
+    out << "Preprocessing:  " << stats.preprocessing.elapsed()  << "s" << endl;
+    out << "Search:         " << stats.search.elapsed()         << "s" << endl;
+    out << "Reconstruction: " << stats.reconstruction.elapsed() << "s" << endl;
+    return out;
+}
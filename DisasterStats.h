@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include "map.h"
+#include "GUI/Timer.h"
+
+/* Macro: STATS_RECORD(stats, action)
+ * ------------------------------------------------------------------------------
+ * Performs the given action on a SearchStats* if statistics collection is compiled
+ * in and the pointer isn't null. For example:
+ *
+ *     STATS_RECORD(stats, visitNode(depth));
+ *     STATS_RECORD(stats, prune(PruneReason::OVER_BUDGET));
+ *
+ * Statistics are only collected if DISASTER_ENABLE_STATS is defined (see the .pro
+ * file). Otherwise, this macro expands to nothing, and the search pays nothing for
+ * the instrumentation.
+ */
+#ifdef DISASTER_ENABLE_STATS
+    #define STATS_RECORD(stats, action) do { if (stats) { (stats)->action; } } while (0)
+#else
+    #define STATS_RECORD(stats, action) do { (void) (stats); } while (0)
+#endif
+
+/* Reasons why the disaster search might abandon a branch. */
+enum class PruneReason {
+    OVER_BUDGET,      // More supply locations chosen than are allowed.
+    UNCOVERED_CITY,   // Every decision was made, but some city still isn't covered.
+    UNCOVERABLE_CITY, // Some city can no longer be covered by any remaining choice.
+    NO_IMPROVEMENT,   // Even the best case can't beat the best plan found so far.
+
+    NUM_REASONS
+};
+
+/* Returns a human-readable name for a prune reason. */
+std::string nameOf(PruneReason reason);
+
+/**
+ * Statistics describing a single run of the disaster search. Pass a pointer to one of
+ * these into placeEmergencySupplies to have it filled in.
+ */
+struct SearchStats {
+    long long nodesVisited = 0;                            // Calls into the search
+    long long prunes[int(PruneReason::NUM_REASONS)] = {};  // Abandoned branches, by reason
+    int maxDepth = 0;                                      // Deepest decision reached
+
+    /* Maps a number of options considered at a node to how many nodes considered
+     * that many options.
+     */
+    Map<int, long long> branchingFactors;
+
+    /* Where the time went. */
+    Timing::Timer preprocessing;   // Building the search's working data
+    Timing::Timer search;          // The search proper
+    Timing::Timer reconstruction;  // Turning the search's answer into a Set<string>
+
+    /* Hooks used by the search via STATS_RECORD. */
+    void visitNode(int depth);
+    void prune(PruneReason reason);
+    void branch(int numOptions);
+
+    /* Total number of prunes, across all reasons. */
+    long long totalPrunes() const;
+};
+
+std::ostream& operator<< (std::ostream& out, const SearchStats& stats);
@@ -0,0 +1,223 @@
+#include "DisasterTrace.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <map>
+#include <memory>
+#include <vector>
+using namespace std;
+
+namespace {
+    /* Number of events each thread can hold. Must be a power of two. */
+    const uint64_t kBufferSize = 1 << 14;
+
+    struct Event {
+        const char* name;
+        const char* label;
+        int64_t     value;
+        int64_t     startNs;
+        int64_t     durationNs;
+        int         threadID;
+    };
+
+    /* A single-producer ring buffer. Only the owning thread writes into it; the
+     * writer publishes each event by bumping the head with release semantics.
+     */
+    struct ThreadBuffer {
+        Event events[kBufferSize];
+        atomic<uint64_t> head{0};
+    };
+
+    /* All buffers ever handed out. Buffers are recycled when their threads exit, but
+     * never freed, so the exporter can always read them.
+     */
+    struct Registry {
+        mutex lock;
+        vector<unique_ptr<ThreadBuffer>> buffers;
+        vector<ThreadBuffer*> freeBuffers;
+        map<int, string> threadNames;
+        int nextThreadID = 1;
+    };
+
+    Registry& registry() {
+        static Registry theRegistry;
+        return theRegistry;
+    }
+
+    atomic<bool> recording{false};
+    atomic<int64_t> epochNs{0};
+
+    int64_t nowNs() {
+        return chrono::duration_cast<chrono::nanoseconds>(
+                    chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /* Per-thread handle to a buffer. Claiming and returning buffers takes the registry
+     * lock, but that happens once per thread rather than once per event.
+     */
+    struct ThreadHandle {
+        ThreadBuffer* buffer;
+        int threadID;
+
+        ThreadHandle() {
+            Registry& reg = registry();
+            lock_guard<mutex> guard(reg.lock);
+            if (reg.freeBuffers.empty()) {
+                reg.buffers.emplace_back(new ThreadBuffer);
+                buffer = reg.buffers.back().get();
+            } else {
+                buffer = reg.freeBuffers.back();
+                reg.freeBuffers.pop_back();
+            }
+            threadID = reg.nextThreadID++;
+        }
+
+        ~ThreadHandle() {
+            Registry& reg = registry();
+            lock_guard<mutex> guard(reg.lock);
+            reg.freeBuffers.push_back(buffer);
+        }
+    };
+
+    ThreadHandle& thisThread() {
+        thread_local ThreadHandle handle;
+        return handle;
+    }
+
+    void record(const Event& event) {
+        ThreadBuffer* buffer = thisThread().buffer;
+        uint64_t head = buffer->head.load(memory_order_relaxed);
+        buffer->events[head & (kBufferSize - 1)] = event;
+        buffer->head.store(head + 1, memory_order_release);
+    }
+
+    /* Writes a string literal as a JSON string. */
+    void writeString(ostream& out, const string& str) {
+        out << '"';
+        for (char ch: str) {
+            if (ch == '"' || ch == '\\') out << '\\' << ch;
+            else if (static_cast<unsigned char>(ch) < 0x20) out << ' ';
+            else out << ch;
+        }
+        out << '"';
+    }
+}
+
+namespace DisasterTrace {
+    void start() {
+        Registry& reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        for (auto& buffer: reg.buffers) {
+            buffer->head.store(0, memory_order_release);
+        }
+        epochNs = nowNs();
+        recording = true;
+    }
+
+    void stop() {
+        recording = false;
+    }
+
+    bool isRecording() {
+        return recording;
+    }
+
+    void setThreadName(const string& name) {
+        int threadID = thisThread().threadID;
+
+        Registry& reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+        reg.threadNames[threadID] = name;
+    }
+
+    void writeJSON(ostream& out) {
+        Registry& reg = registry();
+        lock_guard<mutex> guard(reg.lock);
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+
+        for (const auto& entry: reg.threadNames) {
+            if (!first) out << ",";
+            first = false;
+
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << entry.first
+                << ",\"args\":{\"name\":";
+            writeString(out, entry.second);
+            out << "}}";
+        }
+
+        int64_t epoch = epochNs;
+        for (const auto& buffer: reg.buffers) {
+            uint64_t head  = buffer->head.load(memory_order_acquire);
+            uint64_t begin = head > kBufferSize? head - kBufferSize : 0;
+
+            for (uint64_t i = begin; i < head; i++) {
+                const Event& event = buffer->events[i & (kBufferSize - 1)];
+                if (!first) out << ",";
+                first = false;
+
+                /* Chrome traces use microseconds. */
+                out << "{\"name\":";
+                writeString(out, event.name);
+                out << ",\"cat\":\"disaster\",\"ph\":\"X\",\"pid\":1"
+                    << ",\"tid\":" << event.threadID
+                    << ",\"ts\":"  << (event.startNs - epoch) / 1000.0
+                    << ",\"dur\":" << event.durationNs / 1000.0;
+                if (event.label != nullptr) {
+                    out << ",\"args\":{";
+                    writeString(out, event.label);
+                    out << ":" << event.value << "}";
+                }
+                out << "}";
+            }
+        }
+
+        out << "]}" << endl;
+    }
+
+    Scope::Scope(const char* name, const char* label, int64_t value)
+        : name_(name), label_(label), value_(value),
+          startNs_(recording.load(memory_order_relaxed)? nowNs() : -1) {
+        // Handled in initializer list
+    }
+
+    Scope::~Scope() {
+        if (startNs_ >= 0 && recording.load(memory_order_relaxed)) {
+            record({ name_, label_, value_, startNs_, nowNs() - startNs_, thisThread().threadID });
+        }
+    }
+}
+
+/* * * * * Test Cases Below This Point * * * * */
+#include "GUI/SimpleTest.h"
+#include <sstream>
+#include <thread>
+
+STUDENT_TEST("Tracer records events from multiple threads as Chrome JSON.") {
+    DisasterTrace::start();
+    {
+        DisasterTrace::Scope outer("outer", "budget", 137);
+        thread worker([] {
+            DisasterTrace::setThreadName("Worker");
+            DisasterTrace::Scope inner("inner");
+        });
+        worker.join();
+    }
+    DisasterTrace::stop();
+
+    /* Nothing should be recorded once we've stopped. */
+    {
+        DisasterTrace::Scope ignored("ignored");
+    }
+
+    ostringstream out;
+    DisasterTrace::writeJSON(out);
+    string json = out.str();
+
+    EXPECT(json.find("\"outer\"") != string::npos);
+    EXPECT(json.find("\"budget\":137") != string::npos);
+    EXPECT(json.find("\"inner\"") != string::npos);
+    EXPECT(json.find("\"Worker\"") != string::npos);
+    EXPECT(json.find("\"ignored\"") == string::npos);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <cstdint>
+
+/* Macro: TRACE_SCOPE(name)
+ * Macro: TRACE_SCOPE_VALUE(name, label, value)
+ * Macro: TRACE_THREAD_NAME(name)
+ * ------------------------------------------------------------------------------
+ * Records the time from this point to the end of the enclosing block as a single
+ * event on the current thread's timeline. The name and label must be string
+ * literals. For example:
+ *
+ *     void solve(int budget) {
+ *         TRACE_SCOPE_VALUE("probe", "budget", budget);
+ *         ...
+ *     }
+ *
+ * TRACE_THREAD_NAME gives the calling thread a name to display in the trace viewer.
+ *
+ * Events are only recorded if DISASTER_ENABLE_TRACE is defined (see the .pro file).
+ * Otherwise, these macros expand to nothing.
+ */
+#ifdef DISASTER_ENABLE_TRACE
+    #define TRACE_JOIN_(x, y) x ## y
+    #define TRACE_JOIN(x, y) TRACE_JOIN_(x, y)
+    #define TRACE_SCOPE(name) \
+        DisasterTrace::Scope TRACE_JOIN(_traceScope, __LINE__)(name)
+    #define TRACE_SCOPE_VALUE(name, label, value) \
+        DisasterTrace::Scope TRACE_JOIN(_traceScope, __LINE__)(name, label, (value))
+    #define TRACE_THREAD_NAME(name) \
+        DisasterTrace::setThreadName(name)
+#else
+    #define TRACE_SCOPE(name)                     do { } while (0)
+    #define TRACE_SCOPE_VALUE(name, label, value) do { } while (0)
+    #define TRACE_THREAD_NAME(name)               do { } while (0)
+#endif
+
+/**
+ * A tracer that records timed events and writes them out in the Chrome Trace Event
+ * format, which can be loaded into Perfetto (ui.perfetto.dev) or chrome://tracing.
+ *
+ * Each thread records into its own fixed-size ring buffer, so recording an event
+ * never takes a lock or allocates memory. If a thread records more events than its
+ * buffer holds, the oldest events are overwritten.
+ */
+namespace DisasterTrace {
+    /* Clears out all recorded events and begins recording new ones. */
+    void start();
+
+    /* Stops recording events. Events already recorded are kept. */
+    void stop();
+
+    /* Whether events are currently being recorded. */
+    bool isRecording();
+
+    /* Gives the calling thread a name to display in the trace viewer. */
+    void setThreadName(const std::string& name);
+
+    /* Writes all recorded events as Chrome Trace Event JSON. This should only be
+     * called once the threads being traced have finished their work.
+     */
+    void writeJSON(std::ostream& out);
+
+    /* Type that records an event spanning its lifetime. Use TRACE_SCOPE rather
+     * than constructing these directly.
+     */
+    class Scope {
+    public:
+        explicit Scope(const char* name, const char* label = nullptr, std::int64_t value = 0);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator= (const Scope&) = delete;
+
+    private:
+        const char*  name_;
+        const char*  label_;
+        std::int64_t value_;
+        std::int64_t startNs_; // Negative if we aren't recording.
+    };
+}
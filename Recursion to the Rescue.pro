@@ -41,6 +41,8 @@ PRE_TARGETDEPS       +=  $${check_version.target}
 # link against libcs106.a, add library headers to search path
 # libcs106 requires libpthread, add link here
 LIBS            +=  -lcs106 -lpthread
+# the disaster benchmarks read peak memory use through psapi on Windows
+win32|win64: LIBS   +=  -lpsapi
 QMAKE_LFLAGS    =   -L$$shell_quote($${SPL_DIR}/lib)
 # put PWD first in search list to allow local copy to shadow if needed
 INCLUDEPATH     +=  $$PWD "$${SPL_DIR}/include"
@@ -52,6 +54,17 @@ INCLUDEPATH     +=  $$PWD "$${SPL_DIR}/include"
 # changes to headers require recompilation
 DEPENDPATH += $$PWD
 
+# uncomment to have the disaster solver fill in SearchStats (see DisasterStats.h)
+# leave off for normal builds, where the instrumentation compiles away entirely
+# DEFINES   +=  DISASTER_ENABLE_STATS
+
+# uncomment to record a Chrome trace of each solve to disaster-trace.json (see DisasterTrace.h)
+# DEFINES   +=  DISASTER_ENABLE_TRACE
+
+# uncomment to count heap allocations (see DisasterAllocations.h)
+# replaces the global operator new, so leave off for normal builds
+# DEFINES   +=  DISASTER_COUNT_ALLOCATIONS
+
 # remove spaces from target executable for better Windows compatibility
 TARGET      =   $$replace(TARGET, " ", _)
 
@@ -95,9 +108,9 @@ OTHER_FILES     *=  $$files(*.txt, true)
 
 CONFIG          +=  sdk_no_version_check   # removes spurious warnings on Mac OS X
 
-# MinGW compiler lags, be conservative and use C++11 on all platforms
-# rather than special case
-CONFIG          +=  c++11
+# The map loader uses std::string_view, so C++17 on all platforms; every
+# compiler Qt currently ships with, MinGW included, supports it.
+CONFIG          +=  c++17
 
 # WARN_ON has -Wall -Wextra, add/remove a few specific warnings
 QMAKE_CXXFLAGS_WARN_ON      +=  -Werror=return-type